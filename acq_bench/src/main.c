@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/mem_blocks.h>
+#include <zephyr/sys/util.h>
+
+#include "emul_imu.h"
+#include "mempool_stats.h"
+
+#define BENCH_NODE DT_ALIAS(stream0)
+
+static const struct device *const bench_dev = DEVICE_DT_GET(BENCH_NODE);
+
+/* The same device read in the three acquisition modes */
+SENSOR_DT_READ_IODEV(poll_iodev, BENCH_NODE, { SENSOR_CHAN_ACCEL_XYZ, 0 });
+
+SENSOR_DT_STREAM_IODEV(drdy_iodev, BENCH_NODE,
+		       { SENSOR_TRIG_DATA_READY, SENSOR_STREAM_DATA_INCLUDE });
+
+SENSOR_DT_STREAM_IODEV(fifo_iodev, BENCH_NODE,
+		       { SENSOR_TRIG_FIFO_FULL, SENSOR_STREAM_DATA_NOP },
+		       { SENSOR_TRIG_FIFO_WATERMARK, SENSOR_STREAM_DATA_INCLUDE });
+
+#define MEMPOOL_BLOCKS CONFIG_ACQ_BENCH_MEMPOOL_BLOCKS
+#define MEMPOOL_BLOCK_SIZE CONFIG_ACQ_BENCH_MEMPOOL_BLOCK_SIZE
+
+BUILD_ASSERT(IS_POWER_OF_TWO(MEMPOOL_BLOCK_SIZE), "mempool block size must be a power of two");
+
+/* every completion holds at least one block, size the CQ to never run out */
+RTIO_DEFINE_WITH_MEMPOOL(bench_ctx, 4, MEMPOOL_BLOCKS, MEMPOOL_BLOCKS, MEMPOOL_BLOCK_SIZE,
+			 sizeof(void *));
+
+/* One polled sample: emulated header and three FIFO entries */
+static uint8_t poll_buf[64] __aligned(8);
+
+/* Decoder output holding @p n frames */
+#define DECODE_BUF_SIZE(type, n) (sizeof(type) + ((n) - 1) * sizeof(((type *)0)->readings[0]))
+#define DECODE_FRAMES 8
+
+static uint8_t accel_buf[DECODE_BUF_SIZE(struct sensor_three_axis_data, DECODE_FRAMES)]
+	__aligned(8);
+
+static const struct sensor_chan_spec accel_chan = { SENSOR_CHAN_ACCEL_XYZ, 0 };
+
+enum bench_mode {
+	BENCH_POLL,
+	BENCH_DRDY,
+	BENCH_FIFO,
+};
+
+static const char *const bench_mode_name[] = {
+	[BENCH_POLL] = "poll",
+	[BENCH_DRDY] = "drdy",
+	[BENCH_FIFO] = "fifo",
+};
+
+/*
+ * Latency histogram with 8 buckets per power of two of microseconds, so
+ * the percentiles are exact to 1/8 from the data ready latency of a few
+ * tens of us up to the seconds of a deep FIFO at a low rate.
+ */
+#define LAT_SUB_BITS 3
+#define LAT_BUCKETS ((32 - LAT_SUB_BITS + 1) * BIT(LAT_SUB_BITS))
+
+struct bench_run {
+	enum bench_mode mode;
+	uint32_t odr_hz;
+	/* FIFO entries, 0 for the modes not using the FIFO */
+	uint32_t watermark;
+	uint32_t period_ns;
+
+	/* sensor timestamp of the first sample, the others are counted from it */
+	uint64_t t0_ns;
+	uint64_t next_idx;
+	bool started;
+
+	uint32_t samples;
+	uint32_t dropped;
+	/* polled samples read more than once */
+	uint32_t duplicates;
+	uint32_t wakeups;
+
+	uint32_t lat_hist[LAT_BUCKETS];
+	uint32_t lat_max_us;
+};
+
+static struct bench_run run;
+
+static uint64_t bench_uptime_ns(void)
+{
+	return k_ticks_to_ns_floor64(k_uptime_ticks());
+}
+
+static uint32_t lat_bucket(uint32_t us)
+{
+	uint32_t msb;
+
+	if (us < BIT(LAT_SUB_BITS)) {
+		return us;
+	}
+
+	msb = find_msb_set(us) - 1;
+
+	return ((msb - LAT_SUB_BITS + 1) << LAT_SUB_BITS) +
+	       ((us >> (msb - LAT_SUB_BITS)) & BIT_MASK(LAT_SUB_BITS));
+}
+
+/* Largest latency falling in bucket @p b */
+static uint32_t lat_bucket_max(uint32_t b)
+{
+	uint32_t group = b >> LAT_SUB_BITS;
+	uint32_t sub = b & BIT_MASK(LAT_SUB_BITS);
+
+	if (group == 0) {
+		return b;
+	}
+
+	return (((BIT(LAT_SUB_BITS) + sub + 1) << (group - 1)) - 1);
+}
+
+static uint32_t lat_percentile(const struct bench_run *r, uint32_t pct)
+{
+	uint64_t rank = DIV_ROUND_UP((uint64_t)r->samples * pct, 100);
+	uint64_t seen = 0;
+
+	if (r->samples == 0) {
+		return 0;
+	}
+
+	for (uint32_t b = 0; b < LAT_BUCKETS; b++) {
+		seen += r->lat_hist[b];
+		if (seen >= rank) {
+			return MIN(lat_bucket_max(b), r->lat_max_us);
+		}
+	}
+
+	return r->lat_max_us;
+}
+
+/*
+ * Account one sample available to the application at @p now_ns. The
+ * sample counter is rebuilt from the sensor timestamp, so gaps are the
+ * samples lost on the way, whatever the mode.
+ */
+static void bench_sample(struct bench_run *r, uint64_t ts_ns, uint64_t now_ns)
+{
+	uint64_t idx, uptime_ns;
+	uint32_t lat_us;
+
+	if (!r->started) {
+		r->t0_ns = ts_ns;
+		r->started = true;
+	}
+
+	idx = (ts_ns >= r->t0_ns) ? (ts_ns - r->t0_ns + r->period_ns / 2) / r->period_ns : 0;
+	if (idx < r->next_idx) {
+		r->duplicates++;
+		return;
+	}
+
+	r->dropped += idx - r->next_idx;
+	r->next_idx = idx + 1;
+	r->samples++;
+
+	/* end to end: from the true sampling instant to the decoded frame */
+	emul_imu_to_uptime_ns(bench_dev, ts_ns, &uptime_ns);
+	lat_us = (now_ns > uptime_ns) ? MIN((now_ns - uptime_ns) / NSEC_PER_USEC, UINT32_MAX)
+				      : 0;
+
+	r->lat_hist[lat_bucket(lat_us)]++;
+	r->lat_max_us = MAX(r->lat_max_us, lat_us);
+}
+
+static int bench_decode(struct bench_run *r, const uint8_t *buf, uint64_t now_ns)
+{
+	struct sensor_three_axis_data *accel_data = (struct sensor_three_axis_data *)accel_buf;
+	const struct sensor_decoder_api *decoder;
+	uint32_t fit = 0;
+	int n, rc;
+
+	rc = sensor_get_decoder(bench_dev, &decoder);
+	if (rc != 0) {
+		return rc;
+	}
+
+	while ((n = decoder->decode(buf, accel_chan, &fit, DECODE_FRAMES, accel_data)) > 0) {
+		for (int k = 0; k < n; k++) {
+			bench_sample(r, accel_data->header.base_timestamp_ns +
+					accel_data->readings[k].timestamp_delta, now_ns);
+		}
+	}
+
+	return 0;
+}
+
+/* Read the latest sample once per output data period */
+static int bench_poll(struct bench_run *r, int64_t end_ms)
+{
+	struct k_timer timer;
+	int rc = 0;
+
+	k_timer_init(&timer, NULL, NULL);
+	k_timer_start(&timer, K_NSEC(r->period_ns), K_NSEC(r->period_ns));
+
+	while (k_uptime_get() < end_ms) {
+		k_timer_status_sync(&timer);
+		r->wakeups++;
+
+		rc = sensor_read(&poll_iodev, &bench_ctx, poll_buf, sizeof(poll_buf));
+		if (rc != 0) {
+			break;
+		}
+
+		rc = bench_decode(r, poll_buf, bench_uptime_ns());
+		if (rc != 0) {
+			break;
+		}
+	}
+
+	k_timer_stop(&timer);
+
+	return rc;
+}
+
+/* Free whatever the device completed before it dropped a cancelled stream */
+static void bench_drain(void)
+{
+	struct rtio_cqe *cqe;
+	uint8_t *buf;
+	uint32_t buf_len;
+
+	/* the device drops the request at its next timer expiry */
+	k_msleep(MAX(CONFIG_EMUL_IMU_TIMER_PERIOD_US / USEC_PER_MSEC, 1) + 10);
+
+	while ((cqe = rtio_cqe_consume(&bench_ctx)) != NULL) {
+		if (cqe->result == 0 &&
+		    rtio_cqe_get_mempool_buffer(&bench_ctx, cqe, &buf, &buf_len) == 0) {
+			rtio_release_buffer(&bench_ctx, buf, buf_len);
+		}
+		rtio_cqe_release(&bench_ctx, cqe);
+	}
+}
+
+/* Decode every buffer the stream completes, one wakeup per completion */
+static int bench_stream(struct bench_run *r, struct rtio_iodev *iodev, int64_t end_ms)
+{
+	struct rtio_sqe *handle;
+	struct rtio_cqe *cqe;
+	uint8_t *buf;
+	uint32_t buf_len;
+	int rc;
+
+	rc = sensor_stream(iodev, &bench_ctx, NULL, &handle);
+	if (rc != 0) {
+		return rc;
+	}
+
+	while (k_uptime_get() < end_ms) {
+		cqe = rtio_cqe_consume_block(&bench_ctx);
+
+		uint64_t now_ns = bench_uptime_ns();
+
+		r->wakeups++;
+		rc = cqe->result;
+		if (rc == 0) {
+			rc = rtio_cqe_get_mempool_buffer(&bench_ctx, cqe, &buf, &buf_len);
+		}
+		rtio_cqe_release(&bench_ctx, cqe);
+
+		if (rc != 0) {
+			break;
+		}
+
+		rc = bench_decode(r, buf, now_ns);
+		rtio_release_buffer(&bench_ctx, buf, buf_len);
+
+		if (rc != 0) {
+			break;
+		}
+	}
+
+	rtio_sqe_cancel(handle);
+	bench_drain();
+
+	return rc;
+}
+
+/* Mempool blocks of two drains in flight at @p odr_hz and @p watermark */
+static uint32_t bench_fifo_blocks(uint32_t odr_hz, uint32_t watermark)
+{
+	uint32_t period_ns = NSEC_PER_SEC / odr_hz;
+	uint32_t timer_ns = MAX(period_ns, CONFIG_EMUL_IMU_TIMER_PERIOD_US * NSEC_PER_USEC);
+	/* the device checks the watermark once per timer expiry */
+	uint32_t entries = watermark + 2 * DIV_ROUND_UP(timer_ns, period_ns);
+
+	return 2 * MEMPOOL_DRAIN_BLOCKS(entries, MEMPOOL_BLOCK_SIZE);
+}
+
+static void bench_print_skip(const struct bench_run *r, const char *reason)
+{
+	printk("{\"mode\":\"%s\",\"odr_hz\":%u,\"watermark\":%u,\"skipped\":\"%s\"}\n",
+	       bench_mode_name[r->mode], r->odr_hz, r->watermark, reason);
+}
+
+static int bench_run(enum bench_mode mode, uint32_t odr_hz, uint32_t watermark)
+{
+	struct sensor_value odr = { .val1 = odr_hz };
+	struct sensor_value wm = { .val1 = watermark };
+	k_thread_runtime_stats_t rt_start, rt_end;
+	struct sys_memory_stats pool;
+	uint64_t start_ns, elapsed_ns, cycles;
+	uint32_t isr_start, isr_cycles;
+	uint32_t ram_bytes;
+	int64_t end_ms;
+	int rc;
+
+	run = (struct bench_run){
+		.mode = mode,
+		.odr_hz = odr_hz,
+		.watermark = watermark,
+		.period_ns = NSEC_PER_SEC / odr_hz,
+	};
+
+	if (mode == BENCH_FIFO && bench_fifo_blocks(odr_hz, watermark) > MEMPOOL_BLOCKS) {
+		bench_print_skip(&run, "mempool");
+		return 0;
+	}
+
+	if (mode == BENCH_FIFO &&
+	    sensor_attr_set(bench_dev, SENSOR_CHAN_ALL, EMUL_IMU_ATTR_FIFO_WATERMARK, &wm) != 0) {
+		bench_print_skip(&run, "watermark");
+		return 0;
+	}
+
+	/* restarts the device with an empty FIFO */
+	rc = sensor_attr_set(bench_dev, SENSOR_CHAN_ALL, SENSOR_ATTR_SAMPLING_FREQUENCY, &odr);
+	if (rc != 0) {
+		bench_print_skip(&run, "odr");
+		return 0;
+	}
+
+	sys_mem_blocks_runtime_stats_reset_max(bench_ctx.block_pool);
+	k_thread_runtime_stats_get(k_current_get(), &rt_start);
+	isr_start = emul_imu_completion_cycles(bench_dev);
+	start_ns = bench_uptime_ns();
+	end_ms = k_uptime_get() + CONFIG_ACQ_BENCH_RUN_MS;
+
+	switch (mode) {
+	case BENCH_POLL:
+		rc = bench_poll(&run, end_ms);
+		break;
+	case BENCH_DRDY:
+		rc = bench_stream(&run, &drdy_iodev, end_ms);
+		break;
+	default:
+		rc = bench_stream(&run, &fifo_iodev, end_ms);
+		break;
+	}
+
+	/* the drain after a stream is not part of the run */
+	elapsed_ns = MAX(bench_uptime_ns() - start_ns, 1);
+	k_thread_runtime_stats_get(k_current_get(), &rt_end);
+	cycles = rt_end.execution_cycles - rt_start.execution_cycles;
+	isr_cycles = emul_imu_completion_cycles(bench_dev) - isr_start;
+
+	if (rc != 0) {
+		printk("{\"mode\":\"%s\",\"odr_hz\":%u,\"watermark\":%u,\"error\":%d}\n",
+		       bench_mode_name[mode], odr_hz, watermark, rc);
+		return rc;
+	}
+
+	if (mode == BENCH_POLL) {
+		ram_bytes = sizeof(poll_buf);
+	} else {
+		sys_mem_blocks_runtime_stats_get(bench_ctx.block_pool, &pool);
+		ram_bytes = pool.max_allocated_bytes;
+	}
+
+	printk("{\"mode\":\"%s\",\"odr_hz\":%u,\"watermark\":%u,\"run_ms\":%llu,"
+	       "\"samples\":%u,\"dropped\":%u,\"duplicates\":%u,"
+	       "\"cycles_per_sample\":%llu,\"isr_cycles_per_sample\":%u,"
+	       "\"busy_cycles_per_sample\":%llu,\"wakeups_per_s\":%llu,"
+	       "\"lat_p50_us\":%u,\"lat_p90_us\":%u,\"lat_p99_us\":%u,\"lat_max_us\":%u,"
+	       "\"ram_bytes\":%u}\n",
+	       bench_mode_name[mode], odr_hz, watermark, elapsed_ns / NSEC_PER_MSEC,
+	       run.samples, run.dropped, run.duplicates, cycles / MAX(run.samples, 1),
+	       isr_cycles / MAX(run.samples, 1), (cycles + isr_cycles) / MAX(run.samples, 1),
+	       (uint64_t)run.wakeups * NSEC_PER_SEC / elapsed_ns, lat_percentile(&run, 50),
+	       lat_percentile(&run, 90), lat_percentile(&run, 99), run.lat_max_us, ram_bytes);
+
+	return 0;
+}
+
+/* Parse a Kconfig list of numbers separated by spaces */
+static size_t bench_parse(const char *s, uint32_t *out, size_t max)
+{
+	size_t n = 0;
+	char *end;
+
+	while (n < max) {
+		unsigned long v = strtoul(s, &end, 10);
+
+		if (end == s) {
+			break;
+		}
+		if (v > 0) {
+			out[n++] = v;
+		}
+		s = end;
+	}
+
+	return n;
+}
+
+int main(void)
+{
+	uint32_t odrs[8], watermarks[8];
+	size_t num_odrs, num_watermarks;
+	uint32_t runs = 0;
+
+	if (!device_is_ready(bench_dev)) {
+		printk("sensor: device %s not ready.\n", bench_dev->name);
+		return 0;
+	}
+
+	num_odrs = bench_parse(CONFIG_ACQ_BENCH_ODRS, odrs, ARRAY_SIZE(odrs));
+	num_watermarks = bench_parse(CONFIG_ACQ_BENCH_WATERMARKS, watermarks,
+				     ARRAY_SIZE(watermarks));
+
+	printk("{\"bench\":\"acq\",\"device\":\"%s\",\"cycles_per_s\":%d,\"run_ms\":%u,"
+	       "\"mempool_bytes\":%u}\n", bench_dev->name, sys_clock_hw_cycles_per_sec(),
+	       CONFIG_ACQ_BENCH_RUN_MS, MEMPOOL_BLOCKS * MEMPOOL_BLOCK_SIZE);
+
+	for (size_t i = 0; i < num_odrs; i++) {
+		if (bench_run(BENCH_POLL, odrs[i], 0) != 0 ||
+		    bench_run(BENCH_DRDY, odrs[i], 0) != 0) {
+			return 0;
+		}
+		runs += 2;
+
+		for (size_t j = 0; j < num_watermarks; j++) {
+			if (bench_run(BENCH_FIFO, odrs[i], watermarks[j]) != 0) {
+				return 0;
+			}
+			runs++;
+		}
+	}
+
+	printk("{\"done\":true,\"runs\":%u}\n", runs);
+
+	return 0;
+}
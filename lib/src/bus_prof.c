@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/iterable_sections.h>
+#include <zephyr/sys/util.h>
+
+#include "bus_prof.h"
+
+static struct bus_prof_dev bus_prof_devs[BUS_PROF_MAX_DEVICES];
+static uint8_t bus_prof_num_devs;
+static struct k_spinlock bus_prof_lock;
+static int64_t bus_prof_start_ms;
+static uint32_t bus_prof_interval_ms;
+
+static void bus_prof_submit(struct rtio_iodev_sqe *iodev_sqe);
+
+static const struct rtio_iodev_api bus_prof_api = {
+	.submit = bus_prof_submit,
+};
+
+static struct bus_prof_dev *bus_prof_find(const struct rtio_iodev *iodev)
+{
+	for (uint8_t i = 0; i < bus_prof_num_devs; i++) {
+		if (bus_prof_devs[i].iodev == iodev) {
+			return &bus_prof_devs[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Payload bytes moved by one SQE */
+static uint32_t bus_prof_sqe_bytes(const struct rtio_sqe *sqe)
+{
+	switch (sqe->op) {
+	case RTIO_OP_TX:
+		return sqe->tx.buf_len;
+	case RTIO_OP_RX:
+		return sqe->rx.buf_len;
+	case RTIO_OP_TINY_TX:
+		return sqe->tiny_tx.buf_len;
+	case RTIO_OP_TXRX:
+		return sqe->txrx.buf_len;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * The SQEs of a transaction are handed to the bus driver together, as one
+ * submit call of its first SQE. On I2C every message costs a (repeated)
+ * start and the address byte, and every byte 9 clocks with the ACK.
+ */
+static void bus_prof_submit(struct rtio_iodev_sqe *iodev_sqe)
+{
+	struct bus_prof_dev *d = bus_prof_find(iodev_sqe->sqe.iodev);
+	uint32_t bytes = 0;
+	uint64_t clocks = 0;
+	k_spinlock_key_t key;
+
+	for (struct rtio_iodev_sqe *cur = iodev_sqe; cur != NULL; cur = rtio_txn_next(cur)) {
+		uint32_t n = bus_prof_sqe_bytes(&cur->sqe);
+
+		if (n == 0) {
+			continue;
+		}
+
+		bytes += n;
+		clocks += d->spi ? (8ULL * n) : (9ULL * (n + 1) + 1);
+	}
+
+	if (!d->spi) {
+		/* stop condition */
+		clocks++;
+	}
+
+	key = k_spin_lock(&bus_prof_lock);
+	if (bytes > 0) {
+		d->stats.transactions++;
+		d->stats.bytes += bytes;
+		d->stats.busy_ns += (clocks * NSEC_PER_SEC) / d->hz;
+	}
+	k_spin_unlock(&bus_prof_lock, key);
+
+	d->api->submit(iodev_sqe);
+}
+
+#ifdef CONFIG_I2C_RTIO
+static uint32_t bus_prof_i2c_hz(const struct device *bus)
+{
+	static const uint32_t speed_hz[] = {
+		[I2C_SPEED_STANDARD] = 100000,
+		[I2C_SPEED_FAST] = 400000,
+		[I2C_SPEED_FAST_PLUS] = 1000000,
+		[I2C_SPEED_HIGH] = 3400000,
+		[I2C_SPEED_ULTRA] = 5000000,
+	};
+	uint32_t cfg;
+
+	/* not every controller reports its configuration, assume standard mode */
+	if (i2c_get_config(bus, &cfg) != 0 || I2C_SPEED_GET(cfg) >= ARRAY_SIZE(speed_hz) ||
+	    speed_hz[I2C_SPEED_GET(cfg)] == 0) {
+		return speed_hz[I2C_SPEED_STANDARD];
+	}
+
+	return speed_hz[I2C_SPEED_GET(cfg)];
+}
+#endif
+
+/* Fill @p d if @p iodev is a bus iodev, false otherwise */
+static bool bus_prof_probe(struct rtio_iodev *iodev, struct bus_prof_dev *d)
+{
+#ifdef CONFIG_I2C_RTIO
+	if (iodev->api == &i2c_iodev_api) {
+		const struct i2c_dt_spec *spec = iodev->data;
+
+		d->bus = spec->bus;
+		d->addr = spec->addr;
+		d->hz = bus_prof_i2c_hz(spec->bus);
+		d->spi = false;
+		return true;
+	}
+#endif
+#ifdef CONFIG_SPI_RTIO
+	if (iodev->api == &spi_iodev_api) {
+		const struct spi_dt_spec *spec = iodev->data;
+
+		d->bus = spec->bus;
+		d->addr = spec->config.slave;
+		d->hz = MAX(spec->config.frequency, 1);
+		d->spi = true;
+		return true;
+	}
+#endif
+	ARG_UNUSED(iodev);
+	ARG_UNUSED(d);
+
+	return false;
+}
+
+static void bus_prof_work_handler(struct k_work *work)
+{
+	bus_prof_report();
+	k_work_reschedule(k_work_delayable_from_work(work), K_MSEC(bus_prof_interval_ms));
+}
+
+static K_WORK_DELAYABLE_DEFINE(bus_prof_work, bus_prof_work_handler);
+
+int bus_prof_init(uint32_t interval_ms)
+{
+	STRUCT_SECTION_FOREACH(rtio_iodev, iodev) {
+		struct bus_prof_dev *d;
+
+		if (bus_prof_num_devs == BUS_PROF_MAX_DEVICES) {
+			printk("bus prof: more than %u bus iodevs, not all profiled\n",
+			       BUS_PROF_MAX_DEVICES);
+			break;
+		}
+
+		d = &bus_prof_devs[bus_prof_num_devs];
+		if (!bus_prof_probe(iodev, d)) {
+			continue;
+		}
+
+		d->iodev = iodev;
+		d->api = iodev->api;
+		iodev->api = &bus_prof_api;
+		bus_prof_num_devs++;
+
+		printk("bus prof: %s %s 0x%02x at %u Hz\n", d->bus->name, d->spi ? "cs" : "addr",
+		       d->addr, d->hz);
+	}
+
+	bus_prof_start_ms = k_uptime_get();
+	bus_prof_interval_ms = interval_ms;
+	if (interval_ms > 0) {
+		k_work_schedule(&bus_prof_work, K_MSEC(interval_ms));
+	}
+
+	return bus_prof_num_devs;
+}
+
+/* Utilization of @p busy_ns over @p period_ms, in 1/100 % */
+static uint32_t bus_prof_util(uint64_t busy_ns, uint64_t period_ms)
+{
+	return (busy_ns * 100) / (period_ms * (NSEC_PER_MSEC / 100));
+}
+
+void bus_prof_report(void)
+{
+	struct bus_prof_stats stats[BUS_PROF_MAX_DEVICES];
+	int64_t now_ms = k_uptime_get();
+	uint64_t period_ms = MAX(now_ms - bus_prof_start_ms, 1);
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&bus_prof_lock);
+	for (uint8_t i = 0; i < bus_prof_num_devs; i++) {
+		stats[i] = bus_prof_devs[i].stats;
+		memset(&bus_prof_devs[i].stats, 0, sizeof(bus_prof_devs[i].stats));
+	}
+	bus_prof_start_ms = now_ms;
+	k_spin_unlock(&bus_prof_lock, key);
+
+	for (uint8_t i = 0; i < bus_prof_num_devs; i++) {
+		const struct device *bus = bus_prof_devs[i].bus;
+		struct bus_prof_stats total = { 0 };
+		bool first = true;
+		uint32_t util;
+
+		/* print each bus once, at its first device */
+		for (uint8_t j = 0; j < bus_prof_num_devs; j++) {
+			if (bus_prof_devs[j].bus != bus) {
+				continue;
+			}
+			if (j < i) {
+				first = false;
+				break;
+			}
+			total.transactions += stats[j].transactions;
+			total.bytes += stats[j].bytes;
+			total.busy_ns += stats[j].busy_ns;
+		}
+
+		if (!first) {
+			continue;
+		}
+
+		util = bus_prof_util(total.busy_ns, period_ms);
+		printk("bus %s: %u transactions, %u bytes, busy %llu us in %llu ms (%u.%02u%%)\n",
+		       bus->name, total.transactions, total.bytes, total.busy_ns / NSEC_PER_USEC,
+		       period_ms, util / 100, util % 100);
+
+		for (uint8_t j = i; j < bus_prof_num_devs; j++) {
+			const struct bus_prof_dev *d = &bus_prof_devs[j];
+
+			if (d->bus != bus) {
+				continue;
+			}
+
+			util = bus_prof_util(stats[j].busy_ns, period_ms);
+			printk("bus %s %s 0x%02x: %u transactions, %u bytes/transaction, "
+			       "%u.%02u%%, room for %u such devices\n", bus->name,
+			       d->spi ? "cs" : "addr", d->addr, stats[j].transactions,
+			       stats[j].bytes / MAX(stats[j].transactions, 1),
+			       util / 100, util % 100, 10000 / MAX(util, 1));
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BUS_PROF_H_
+#define BUS_PROF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/device.h>
+#include <zephyr/rtio/rtio.h>
+
+#define BUS_PROF_MAX_DEVICES	8
+
+struct bus_prof_stats {
+	uint32_t transactions;
+	uint32_t bytes;
+	/* time the clock runs on the wire, from the bus frequency */
+	uint64_t busy_ns;
+};
+
+/* One I2C or SPI iodev a sensor driver issues its bus transfers to */
+struct bus_prof_dev {
+	struct rtio_iodev *iodev;
+	/* the bus API the profiler forwards to */
+	const struct rtio_iodev_api *api;
+	const struct device *bus;
+	bool spi;
+	/* I2C address or SPI chip select */
+	uint16_t addr;
+	uint32_t hz;
+	struct bus_prof_stats stats;
+};
+
+/**
+ * @brief Start profiling the I2C and SPI RTIO iodevs.
+ *
+ * Every I2C (CONFIG_I2C_RTIO) and SPI (CONFIG_SPI_RTIO) iodev gets its
+ * submit call routed through the profiler, which accounts each
+ * transaction before forwarding it. This covers the transfers of the
+ * stream and read requests the sensor drivers turn into bus SQEs. Must
+ * run before the first request is submitted.
+ *
+ * @param interval_ms Report period, 0 to only report on bus_prof_report()
+ * @return Number of iodevs profiled
+ */
+int bus_prof_init(uint32_t interval_ms);
+
+/**
+ * @brief Print the traffic since the previous report and reset it.
+ *
+ * One line per bus and one per device: transactions, bytes and busy time,
+ * and the bus utilization they amount to over the report period.
+ */
+void bus_prof_report(void);
+
+#endif /* BUS_PROF_H_ */
@@ -0,0 +1,886 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define DT_DRV_COMPAT zephyr_emul_imu
+
+#include <errno.h>
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/spinlock.h>
+
+#include "emul_imu.h"
+
+/* FIFO entry tags, the low bits of the tag byte hold the sample counter */
+#define EMUL_IMU_TAG_XL		1
+#define EMUL_IMU_TAG_GY		2
+#define EMUL_IMU_TAG_TEMP	3
+#define EMUL_IMU_TAG_ROT	4
+#define EMUL_IMU_TAG_GRAVITY	5
+#define EMUL_IMU_TAG_SHIFT	5
+#define EMUL_IMU_CNT_MASK	BIT_MASK(EMUL_IMU_TAG_SHIFT)
+
+/* Raw units: accel 1 mg, gyro 1/64 dps, temperature 1/256 degC */
+#define EMUL_IMU_XL_SHIFT	9
+#define EMUL_IMU_GY_SHIFT	4
+#define EMUL_IMU_TEMP_SHIFT	8
+/* raw * 9.80665e-3 m/s^2 in q31 with a shift of 9 */
+#define EMUL_IMU_XL_Q31(raw)	((q31_t)(((int64_t)(raw) * 9806650LL * BIT(22)) / 1000000000LL))
+/* raw * pi / (180 * 64) rad/s in q31 with a shift of 4 */
+#define EMUL_IMU_GY_Q31(raw)	((q31_t)((int64_t)(raw) * 36603))
+/* raw / 256 degC in q31 with a shift of 8 */
+#define EMUL_IMU_TEMP_Q31(raw)	((q31_t)((int64_t)(raw) * BIT(15)))
+/* Game rotation x, y, z in q15, w is rebuilt by the decoder; q31 with a shift of 1 */
+#define EMUL_IMU_ROT_SHIFT	1
+#define EMUL_IMU_ROT_Q31(raw)	((q31_t)((int64_t)(raw) * BIT(15)))
+
+struct emul_imu_entry {
+	uint8_t tag;
+	int16_t v[3];
+} __packed;
+
+/* Header of every buffer produced by the device, followed by FIFO entries */
+struct emul_imu_header {
+	/* sensor clock timestamp of sample 'seq' */
+	uint64_t timestamp_ns;
+	uint32_t period_ns;
+	/* sample counter of the first entry */
+	uint32_t seq;
+	/* BIT(enum sensor_trigger_type) of the triggers that fired */
+	uint32_t triggers;
+	uint16_t count;
+	uint16_t reserved;
+};
+
+struct emul_imu_config {
+	uint32_t odr_hz;
+	uint16_t watermark;
+	uint16_t temp_divider;
+	int32_t drift_ppb;
+	int64_t offset_ns;
+	uint16_t motion_amplitude_deg;
+	uint32_t motion_period_ms;
+	uint16_t sflp_divider;
+};
+
+/* True state of the emulated device at one sample */
+struct emul_imu_motion {
+	/* accel in mg, gyro in 1/64 dps */
+	int16_t xl[3];
+	int16_t gy[3];
+	/* game rotation x, y, z in q15 (w >= 0) and gravity in mg */
+	int16_t rot[3];
+	int16_t gravity[3];
+};
+
+struct emul_imu_data {
+	struct k_timer timer;
+	struct k_spinlock lock;
+	const struct device *dev;
+
+	/* pending multishot stream request and its trigger configuration */
+	struct rtio_iodev_sqe *stream_sqe;
+	bool trig_watermark;
+	bool trig_drdy;
+	bool trig_full;
+	enum sensor_stream_data_opt full_opt;
+
+	struct emul_imu_entry fifo[CONFIG_EMUL_IMU_FIFO_ENTRIES];
+	uint16_t fifo_head;
+	uint16_t fifo_count;
+	/* sample counter of the oldest FIFO entry */
+	uint32_t fifo_seq;
+	bool fifo_overrun;
+	uint32_t overruns;
+
+	/* output data rate and watermark, from devicetree until set at runtime */
+	uint32_t odr_hz;
+	uint16_t watermark;
+
+	uint64_t start_sensor_ns;
+	uint32_t period_ns;
+	uint32_t next_seq;
+	uint32_t rng;
+
+	/* cycles spent completing stream requests, only the handler writes it */
+	uint32_t completion_cycles;
+};
+
+static const struct sensor_driver_api emul_imu_api;
+
+static uint64_t emul_imu_uptime_ns(void)
+{
+	return k_ticks_to_ns_floor64(k_uptime_ticks());
+}
+
+static uint64_t emul_imu_sensor_clock(const struct emul_imu_config *cfg, uint64_t uptime_ns)
+{
+	int64_t t = (int64_t)uptime_ns;
+
+	return cfg->offset_ns + t + (t * cfg->drift_ppb) / (int64_t)NSEC_PER_SEC;
+}
+
+int emul_imu_to_uptime_ns(const struct device *dev, uint64_t sensor_ns, uint64_t *uptime_ns)
+{
+	const struct emul_imu_config *cfg;
+	int64_t x;
+
+	if (dev->api != &emul_imu_api) {
+		return -ENODEV;
+	}
+
+	cfg = dev->config;
+	x = (int64_t)sensor_ns - cfg->offset_ns;
+	*uptime_ns = x - (x * cfg->drift_ppb) / ((int64_t)NSEC_PER_SEC + cfg->drift_ppb);
+
+	return 0;
+}
+
+uint32_t emul_imu_overruns(const struct device *dev)
+{
+	const struct emul_imu_data *data = dev->data;
+
+	return data->overruns;
+}
+
+uint32_t emul_imu_completion_cycles(const struct device *dev)
+{
+	const struct emul_imu_data *data = dev->data;
+
+	return data->completion_cycles;
+}
+
+static int16_t emul_imu_noise(struct emul_imu_data *data, int16_t amplitude)
+{
+	/* xorshift32 */
+	data->rng ^= data->rng << 13;
+	data->rng ^= data->rng >> 17;
+	data->rng ^= data->rng << 5;
+
+	return (int16_t)(data->rng % (2 * amplitude + 1)) - amplitude;
+}
+
+/* sin() of a 16-bit angle in q15, from a quarter wave table */
+static int32_t emul_imu_sin16(uint16_t angle)
+{
+	static const int16_t quarter[65] = {
+		0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+		6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+		12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+		18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+		23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+		27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+		30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+		32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+		32767,
+	};
+	uint16_t a = angle & 0x3fff;
+	uint16_t idx, frac;
+	int32_t v;
+
+	/* mirror the second and fourth quarters */
+	if (angle & 0x4000) {
+		a = 0x4000 - a;
+	}
+
+	idx = a >> 8;
+	frac = a & 0xff;
+	v = quarter[idx];
+	if (idx < 64) {
+		v += ((quarter[idx + 1] - v) * frac) >> 8;
+	}
+
+	return (angle & 0x8000) ? -v : v;
+}
+
+static int32_t emul_imu_cos16(uint16_t angle)
+{
+	return emul_imu_sin16(angle + 0x4000);
+}
+
+/*
+ * The device tilts back and forth around its x axis:
+ * theta(t) = amplitude * sin(2 * pi * t / period). Without motion it lies
+ * flat and still.
+ */
+static void emul_imu_motion(const struct emul_imu_config *cfg, uint32_t sample_period_ns,
+			    uint32_t seq, struct emul_imu_motion *m)
+{
+	uint64_t period_ns = (uint64_t)cfg->motion_period_ms * NSEC_PER_MSEC;
+	uint64_t t_ns = (uint64_t)seq * sample_period_ns;
+	uint16_t phase = 0;
+	int32_t theta_mdeg = 0, rate = 0;
+	/* theta and theta / 2 as signed 16-bit angles */
+	int16_t theta, half;
+
+	if (cfg->motion_amplitude_deg > 0 && period_ns > 0) {
+		phase = ((t_ns % period_ns) << 16) / period_ns;
+		theta_mdeg = ((int64_t)cfg->motion_amplitude_deg * 1000 *
+			      emul_imu_sin16(phase)) >> 15;
+		/* d(theta)/dt in 1/64 dps, 6283 = 2 * pi * 1000 */
+		rate = ((int64_t)cfg->motion_amplitude_deg * 64 * 6283 * emul_imu_cos16(phase)) /
+		       ((int64_t)cfg->motion_period_ms * BIT(15));
+	}
+
+	theta = (int64_t)theta_mdeg * 65536 / 360000;
+	half = (int64_t)theta_mdeg * 32768 / 360000;
+
+	m->gravity[0] = 0;
+	m->gravity[1] = (1000 * emul_imu_sin16(theta)) >> 15;
+	m->gravity[2] = (1000 * emul_imu_cos16(theta)) >> 15;
+
+	m->xl[0] = m->gravity[0];
+	m->xl[1] = m->gravity[1];
+	m->xl[2] = m->gravity[2];
+
+	m->gy[0] = rate;
+	m->gy[1] = 0;
+	m->gy[2] = 0;
+
+	/* q = (cos(theta / 2), sin(theta / 2), 0, 0) */
+	m->rot[0] = CLAMP(emul_imu_sin16(half), INT16_MIN, INT16_MAX);
+	m->rot[1] = 0;
+	m->rot[2] = 0;
+}
+
+static void emul_imu_fifo_push(struct emul_imu_data *data, uint8_t tag, uint32_t seq,
+			       int16_t x, int16_t y, int16_t z)
+{
+	uint16_t idx;
+
+	if (data->fifo_count == ARRAY_SIZE(data->fifo)) {
+		/* stream mode: the oldest entry is overwritten */
+		uint8_t old_cnt = data->fifo[data->fifo_head].tag & EMUL_IMU_CNT_MASK;
+
+		data->fifo_head = (data->fifo_head + 1) % ARRAY_SIZE(data->fifo);
+		data->fifo_count--;
+		data->overruns++;
+		data->fifo_overrun = true;
+
+		if (data->fifo_count > 0) {
+			uint8_t cnt = data->fifo[data->fifo_head].tag & EMUL_IMU_CNT_MASK;
+
+			data->fifo_seq += (cnt - old_cnt) & EMUL_IMU_CNT_MASK;
+		}
+	}
+
+	if (data->fifo_count == 0) {
+		data->fifo_seq = seq;
+	}
+
+	idx = (data->fifo_head + data->fifo_count) % ARRAY_SIZE(data->fifo);
+	data->fifo[idx].tag = (tag << EMUL_IMU_TAG_SHIFT) | (seq & EMUL_IMU_CNT_MASK);
+	data->fifo[idx].v[0] = x;
+	data->fifo[idx].v[1] = y;
+	data->fifo[idx].v[2] = z;
+	data->fifo_count++;
+}
+
+static void emul_imu_generate(const struct device *dev, uint32_t seq)
+{
+	const struct emul_imu_config *cfg = dev->config;
+	struct emul_imu_data *data = dev->data;
+	struct emul_imu_motion m;
+
+	emul_imu_motion(cfg, data->period_ns, seq, &m);
+
+	emul_imu_fifo_push(data, EMUL_IMU_TAG_XL, seq,
+			   m.xl[0] + emul_imu_noise(data, 4), m.xl[1] + emul_imu_noise(data, 4),
+			   m.xl[2] + emul_imu_noise(data, 4));
+	emul_imu_fifo_push(data, EMUL_IMU_TAG_GY, seq,
+			   m.gy[0] + emul_imu_noise(data, 2), m.gy[1] + emul_imu_noise(data, 2),
+			   m.gy[2] + emul_imu_noise(data, 2));
+
+	/* noiseless reference orientation, like the SFLP outputs of real devices */
+	if (cfg->sflp_divider > 0 && (seq % cfg->sflp_divider) == 0) {
+		emul_imu_fifo_push(data, EMUL_IMU_TAG_ROT, seq, m.rot[0], m.rot[1], m.rot[2]);
+		emul_imu_fifo_push(data, EMUL_IMU_TAG_GRAVITY, seq,
+				   m.gravity[0], m.gravity[1], m.gravity[2]);
+	}
+
+	if (cfg->temp_divider > 0 && (seq % cfg->temp_divider) == 0) {
+		emul_imu_fifo_push(data, EMUL_IMU_TAG_TEMP, seq,
+				   25 * 256 + ((seq >> 10) & 0xff), 0, 0);
+	}
+}
+
+static void emul_imu_fifo_flush(struct emul_imu_data *data)
+{
+	data->fifo_head = 0;
+	data->fifo_count = 0;
+}
+
+/* Copy @p count FIFO entries starting at the oldest one and remove them */
+static void emul_imu_fifo_pop(struct emul_imu_data *data, struct emul_imu_entry *out,
+			      uint16_t count)
+{
+	uint8_t first_cnt = data->fifo[data->fifo_head].tag & EMUL_IMU_CNT_MASK;
+	uint8_t last_cnt = first_cnt;
+
+	for (uint16_t i = 0; i < count; i++) {
+		out[i] = data->fifo[data->fifo_head];
+		last_cnt = out[i].tag & EMUL_IMU_CNT_MASK;
+		data->fifo_head = (data->fifo_head + 1) % ARRAY_SIZE(data->fifo);
+	}
+
+	data->fifo_count -= count;
+	data->fifo_seq += (last_cnt - first_cnt) & EMUL_IMU_CNT_MASK;
+
+	if (data->fifo_count > 0) {
+		uint8_t cnt = data->fifo[data->fifo_head].tag & EMUL_IMU_CNT_MASK;
+
+		data->fifo_seq += (cnt - last_cnt) & EMUL_IMU_CNT_MASK;
+	}
+}
+
+/*
+ * Move @p count FIFO entries, after dropping @p skip, into the buffer of the
+ * request. Called with the lock held, the request is completed by the caller
+ * once the lock is released.
+ */
+static int emul_imu_fill(struct emul_imu_data *data, struct rtio_iodev_sqe *iodev_sqe,
+			 uint16_t skip, uint16_t count, uint32_t triggers)
+{
+	uint32_t min_len = sizeof(struct emul_imu_header) + count * sizeof(struct emul_imu_entry);
+	struct emul_imu_header *hdr;
+	uint8_t *buf;
+	uint32_t buf_len;
+	int rc;
+
+	rc = rtio_sqe_rx_buf(iodev_sqe, min_len, min_len, &buf, &buf_len);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (skip > 0) {
+		struct emul_imu_entry dummy;
+
+		for (uint16_t i = 0; i < skip; i++) {
+			emul_imu_fifo_pop(data, &dummy, 1);
+		}
+	}
+
+	hdr = (struct emul_imu_header *)buf;
+	hdr->seq = data->fifo_seq;
+	hdr->period_ns = data->period_ns;
+	hdr->timestamp_ns = data->start_sensor_ns + (uint64_t)hdr->seq * data->period_ns;
+	hdr->triggers = triggers;
+	hdr->count = count;
+	hdr->reserved = 0;
+
+	if (data->fifo_overrun) {
+		hdr->triggers |= BIT(SENSOR_TRIG_FIFO_FULL);
+		data->fifo_overrun = false;
+	}
+
+	emul_imu_fifo_pop(data, (struct emul_imu_entry *)(hdr + 1), count);
+
+	return 0;
+}
+
+/*
+ * Sampling and the FIFO are only touched with the lock held, so that
+ * emul_imu_start() can restart the device while the handler runs on another
+ * CPU: k_timer_stop() does not wait for it.
+ */
+static void emul_imu_timer_handler(struct k_timer *timer)
+{
+	struct emul_imu_data *data = CONTAINER_OF(timer, struct emul_imu_data, timer);
+	const struct device *dev = data->dev;
+	const struct emul_imu_config *cfg = dev->config;
+	struct rtio_iodev_sqe *iodev_sqe;
+	k_spinlock_key_t key;
+	uint64_t sensor_ns;
+	uint32_t first, due, start;
+	uint32_t triggers = 0;
+	uint16_t skip = 0;
+	int rc;
+
+	key = k_spin_lock(&data->lock);
+
+	sensor_ns = emul_imu_sensor_clock(cfg, emul_imu_uptime_ns());
+	due = (sensor_ns - data->start_sensor_ns) / data->period_ns + 1;
+	first = data->next_seq;
+
+	while (data->next_seq != due) {
+		emul_imu_generate(dev, data->next_seq++);
+	}
+
+	iodev_sqe = data->stream_sqe;
+
+	if (iodev_sqe == NULL) {
+		k_spin_unlock(&data->lock, key);
+		return;
+	}
+
+	/* a cancelled stream ends here, so that the request can be freed */
+	if (iodev_sqe->sqe.flags & RTIO_SQE_CANCELED) {
+		data->stream_sqe = NULL;
+		k_spin_unlock(&data->lock, key);
+		rtio_iodev_sqe_err(iodev_sqe, -ECANCELED);
+		return;
+	}
+
+	if (data->trig_drdy) {
+		if (first == due) {
+			k_spin_unlock(&data->lock, key);
+			return;
+		}
+		/* only the entries of the newest sample are reported */
+		while (data->fifo_count > 0 && data->fifo_seq != due - 1) {
+			emul_imu_fifo_pop(data, &(struct emul_imu_entry){ 0 }, 1);
+		}
+		triggers = BIT(SENSOR_TRIG_DATA_READY);
+	} else if (data->trig_full && data->fifo_overrun &&
+		   data->full_opt != SENSOR_STREAM_DATA_NOP) {
+		triggers = BIT(SENSOR_TRIG_FIFO_FULL);
+		if (data->full_opt == SENSOR_STREAM_DATA_DROP) {
+			skip = data->fifo_count;
+		}
+	} else if (data->trig_watermark && data->fifo_count >= data->watermark) {
+		triggers = BIT(SENSOR_TRIG_FIFO_WATERMARK);
+	} else {
+		k_spin_unlock(&data->lock, key);
+		return;
+	}
+
+	/* what a driver does on the interrupt: read the FIFO and complete */
+	start = k_cycle_get_32();
+
+	/*
+	 * Without a buffer the stream ends with -ENOMEM like on the real
+	 * drivers, the data stays in the FIFO for the next request.
+	 */
+	rc = emul_imu_fill(data, iodev_sqe, skip, data->fifo_count - skip, triggers);
+	data->stream_sqe = NULL;
+
+	k_spin_unlock(&data->lock, key);
+
+	/* completing may resubmit the multishot request from this context */
+	if (rc == 0) {
+		rtio_iodev_sqe_ok(iodev_sqe, 0);
+	} else {
+		rtio_iodev_sqe_err(iodev_sqe, rc);
+	}
+
+	data->completion_cycles += k_cycle_get_32() - start;
+}
+
+static void emul_imu_read(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+	const struct emul_imu_config *cfg = dev->config;
+	struct emul_imu_data *data = dev->data;
+	uint32_t min_len = sizeof(struct emul_imu_header) + 3 * sizeof(struct emul_imu_entry);
+	struct emul_imu_header *hdr;
+	struct emul_imu_entry *entry;
+	struct emul_imu_motion m;
+	k_spinlock_key_t key;
+	uint64_t sensor_ns;
+	uint32_t seq;
+	uint8_t *buf;
+	uint32_t buf_len;
+	int rc;
+
+	rc = rtio_sqe_rx_buf(iodev_sqe, min_len, min_len, &buf, &buf_len);
+	if (rc != 0) {
+		rtio_iodev_sqe_err(iodev_sqe, rc);
+		return;
+	}
+
+	/* the ODR can change from another thread, and the noise state is shared */
+	key = k_spin_lock(&data->lock);
+
+	sensor_ns = emul_imu_sensor_clock(cfg, emul_imu_uptime_ns());
+	seq = (sensor_ns - data->start_sensor_ns) / data->period_ns;
+	emul_imu_motion(cfg, data->period_ns, seq, &m);
+
+	hdr = (struct emul_imu_header *)buf;
+	hdr->seq = seq;
+	hdr->period_ns = data->period_ns;
+	hdr->timestamp_ns = data->start_sensor_ns + (uint64_t)seq * data->period_ns;
+	hdr->triggers = 0;
+	hdr->count = 3;
+	hdr->reserved = 0;
+
+	entry = (struct emul_imu_entry *)(hdr + 1);
+	entry[0] = (struct emul_imu_entry){
+		.tag = (EMUL_IMU_TAG_XL << EMUL_IMU_TAG_SHIFT) | (seq & EMUL_IMU_CNT_MASK),
+		.v = { m.xl[0] + emul_imu_noise(data, 4), m.xl[1] + emul_imu_noise(data, 4),
+		       m.xl[2] + emul_imu_noise(data, 4) },
+	};
+	entry[1] = (struct emul_imu_entry){
+		.tag = (EMUL_IMU_TAG_GY << EMUL_IMU_TAG_SHIFT) | (seq & EMUL_IMU_CNT_MASK),
+		.v = { m.gy[0] + emul_imu_noise(data, 2), m.gy[1] + emul_imu_noise(data, 2),
+		       m.gy[2] + emul_imu_noise(data, 2) },
+	};
+	entry[2] = (struct emul_imu_entry){
+		.tag = (EMUL_IMU_TAG_TEMP << EMUL_IMU_TAG_SHIFT) | (seq & EMUL_IMU_CNT_MASK),
+		.v = { 25 * 256, 0, 0 },
+	};
+
+	k_spin_unlock(&data->lock, key);
+
+	rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+static void emul_imu_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+	const struct sensor_read_config *read_cfg = iodev_sqe->sqe.iodev->data;
+	struct emul_imu_data *data = dev->data;
+	k_spinlock_key_t key;
+
+	if (!read_cfg->is_streaming) {
+		emul_imu_read(dev, iodev_sqe);
+		return;
+	}
+
+	key = k_spin_lock(&data->lock);
+
+	data->trig_watermark = false;
+	data->trig_drdy = false;
+	data->trig_full = false;
+
+	for (size_t i = 0; i < read_cfg->count; i++) {
+		switch (read_cfg->triggers[i].trigger) {
+		case SENSOR_TRIG_FIFO_WATERMARK:
+			data->trig_watermark = true;
+			break;
+		case SENSOR_TRIG_DATA_READY:
+			data->trig_drdy = true;
+			break;
+		case SENSOR_TRIG_FIFO_FULL:
+			data->trig_full = true;
+			data->full_opt = read_cfg->triggers[i].opt;
+			break;
+		default:
+			break;
+		}
+	}
+
+	data->stream_sqe = iodev_sqe;
+
+	k_spin_unlock(&data->lock, key);
+}
+
+/* (Re)start sampling at @p odr_hz from sample 0, with an empty FIFO */
+static void emul_imu_start(const struct device *dev, uint32_t odr_hz)
+{
+	const struct emul_imu_config *cfg = dev->config;
+	struct emul_imu_data *data = dev->data;
+	uint32_t timer_ns;
+	k_spinlock_key_t key;
+
+	k_timer_stop(&data->timer);
+
+	key = k_spin_lock(&data->lock);
+	data->odr_hz = odr_hz;
+	data->period_ns = NSEC_PER_SEC / odr_hz;
+	data->start_sensor_ns = emul_imu_sensor_clock(cfg, emul_imu_uptime_ns());
+	data->next_seq = 0;
+	data->fifo_overrun = false;
+	emul_imu_fifo_flush(data);
+	k_spin_unlock(&data->lock, key);
+
+	/* generate in bursts when the ODR is faster than the timer tick */
+	timer_ns = MAX(data->period_ns, CONFIG_EMUL_IMU_TIMER_PERIOD_US * NSEC_PER_USEC);
+	k_timer_start(&data->timer, K_NSEC(timer_ns), K_NSEC(timer_ns));
+}
+
+static bool emul_imu_odr_chan(enum sensor_channel chan)
+{
+	return chan == SENSOR_CHAN_ACCEL_XYZ || chan == SENSOR_CHAN_GYRO_XYZ;
+}
+
+static int emul_imu_attr_set(const struct device *dev, enum sensor_channel chan,
+			     enum sensor_attribute attr, const struct sensor_value *val)
+{
+	struct emul_imu_data *data = dev->data;
+	k_spinlock_key_t key;
+
+	switch (attr) {
+	case SENSOR_ATTR_SAMPLING_FREQUENCY:
+		/* accel and gyro share the ODR */
+		if (!emul_imu_odr_chan(chan) && chan != SENSOR_CHAN_ALL) {
+			return -ENOTSUP;
+		}
+		if (val->val1 <= 0 || (uint32_t)val->val1 > NSEC_PER_SEC) {
+			return -EINVAL;
+		}
+		emul_imu_start(dev, val->val1);
+		return 0;
+	case EMUL_IMU_ATTR_FIFO_WATERMARK:
+		if (val->val1 <= 0 || val->val1 > CONFIG_EMUL_IMU_FIFO_ENTRIES) {
+			return -EINVAL;
+		}
+		key = k_spin_lock(&data->lock);
+		data->watermark = val->val1;
+		k_spin_unlock(&data->lock, key);
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+}
+
+static int emul_imu_attr_get(const struct device *dev, enum sensor_channel chan,
+			     enum sensor_attribute attr, struct sensor_value *val)
+{
+	const struct emul_imu_data *data = dev->data;
+
+	switch (attr) {
+	case SENSOR_ATTR_SAMPLING_FREQUENCY:
+		if (!emul_imu_odr_chan(chan)) {
+			return -ENOTSUP;
+		}
+		val->val1 = data->odr_hz;
+		break;
+	case EMUL_IMU_ATTR_FIFO_WATERMARK:
+		val->val1 = data->watermark;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	val->val2 = 0;
+
+	return 0;
+}
+
+static uint8_t emul_imu_chan_tag(enum sensor_channel chan)
+{
+	switch (chan) {
+	case SENSOR_CHAN_ACCEL_XYZ:
+		return EMUL_IMU_TAG_XL;
+	case SENSOR_CHAN_GYRO_XYZ:
+		return EMUL_IMU_TAG_GY;
+	case SENSOR_CHAN_DIE_TEMP:
+		return EMUL_IMU_TAG_TEMP;
+	case SENSOR_CHAN_GAME_ROTATION_VECTOR:
+		return EMUL_IMU_TAG_ROT;
+	case SENSOR_CHAN_GRAVITY_VECTOR:
+		return EMUL_IMU_TAG_GRAVITY;
+	default:
+		return 0;
+	}
+}
+
+static int emul_imu_decoder_get_frame_count(const uint8_t *buffer, struct sensor_chan_spec chan,
+					    uint16_t *frame_count)
+{
+	const struct emul_imu_header *hdr = (const struct emul_imu_header *)buffer;
+	const struct emul_imu_entry *entry = (const struct emul_imu_entry *)(hdr + 1);
+	uint8_t tag = emul_imu_chan_tag(chan.chan_type);
+
+	*frame_count = 0;
+
+	if (chan.chan_idx != 0 || tag == 0) {
+		return 0;
+	}
+
+	for (uint16_t i = 0; i < hdr->count; i++) {
+		if ((entry[i].tag >> EMUL_IMU_TAG_SHIFT) == tag) {
+			(*frame_count)++;
+		}
+	}
+
+	return 0;
+}
+
+static int emul_imu_decoder_get_size_info(struct sensor_chan_spec chan, size_t *base_size,
+					  size_t *frame_size)
+{
+	switch (chan.chan_type) {
+	case SENSOR_CHAN_ACCEL_XYZ:
+	case SENSOR_CHAN_GYRO_XYZ:
+	case SENSOR_CHAN_GRAVITY_VECTOR:
+		*base_size = sizeof(struct sensor_three_axis_data);
+		*frame_size = sizeof(struct sensor_three_axis_sample_data);
+		return 0;
+	case SENSOR_CHAN_DIE_TEMP:
+		*base_size = sizeof(struct sensor_q31_data);
+		*frame_size = sizeof(struct sensor_q31_sample_data);
+		return 0;
+	case SENSOR_CHAN_GAME_ROTATION_VECTOR:
+		*base_size = sizeof(struct sensor_game_rotation_vector_data);
+		*frame_size = sizeof(((struct sensor_game_rotation_vector_data *)0)->readings[0]);
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+}
+
+/* w = sqrt(1 - x^2 - y^2 - z^2) of a q15 unit quaternion with w >= 0 */
+static int16_t emul_imu_rot_w(const int16_t *v)
+{
+	int64_t w2 = BIT64(30) - (int64_t)v[0] * v[0] - (int64_t)v[1] * v[1] -
+		     (int64_t)v[2] * v[2];
+	uint32_t w = 0;
+
+	/* bitwise integer square root */
+	for (uint32_t bit = BIT(15); bit != 0; bit >>= 1) {
+		if ((int64_t)(w | bit) * (w | bit) <= w2) {
+			w |= bit;
+		}
+	}
+
+	return MIN(w, INT16_MAX);
+}
+
+static int emul_imu_decoder_decode(const uint8_t *buffer, struct sensor_chan_spec chan,
+				   uint32_t *fit, uint16_t max_count, void *data_out)
+{
+	const struct emul_imu_header *hdr = (const struct emul_imu_header *)buffer;
+	const struct emul_imu_entry *entry = (const struct emul_imu_entry *)(hdr + 1);
+	uint8_t tag = emul_imu_chan_tag(chan.chan_type);
+	struct sensor_three_axis_data *xyz = data_out;
+	struct sensor_q31_data *q31 = data_out;
+	struct sensor_game_rotation_vector_data *rot = data_out;
+	uint32_t seq = hdr->seq;
+	uint8_t cnt;
+	uint64_t base_ns = 0;
+	uint16_t n = 0;
+
+	if (chan.chan_idx != 0 || tag == 0 || hdr->count == 0) {
+		return 0;
+	}
+
+	cnt = entry[0].tag & EMUL_IMU_CNT_MASK;
+
+	for (uint32_t i = 0; i < hdr->count && n < max_count; i++) {
+		uint8_t entry_cnt = entry[i].tag & EMUL_IMU_CNT_MASK;
+		uint64_t ts;
+
+		/* rebuild the full sample counter from the tag counter */
+		seq += (entry_cnt - cnt) & EMUL_IMU_CNT_MASK;
+		cnt = entry_cnt;
+
+		if (i < *fit || (entry[i].tag >> EMUL_IMU_TAG_SHIFT) != tag) {
+			continue;
+		}
+
+		ts = hdr->timestamp_ns + (uint64_t)(seq - hdr->seq) * hdr->period_ns;
+		if (n == 0) {
+			base_ns = ts;
+		}
+
+		switch (tag) {
+		case EMUL_IMU_TAG_XL:
+		case EMUL_IMU_TAG_GRAVITY:
+			xyz->readings[n].timestamp_delta = ts - base_ns;
+			xyz->readings[n].x = EMUL_IMU_XL_Q31(entry[i].v[0]);
+			xyz->readings[n].y = EMUL_IMU_XL_Q31(entry[i].v[1]);
+			xyz->readings[n].z = EMUL_IMU_XL_Q31(entry[i].v[2]);
+			break;
+		case EMUL_IMU_TAG_GY:
+			xyz->readings[n].timestamp_delta = ts - base_ns;
+			xyz->readings[n].x = EMUL_IMU_GY_Q31(entry[i].v[0]);
+			xyz->readings[n].y = EMUL_IMU_GY_Q31(entry[i].v[1]);
+			xyz->readings[n].z = EMUL_IMU_GY_Q31(entry[i].v[2]);
+			break;
+		case EMUL_IMU_TAG_ROT:
+			rot->readings[n].timestamp_delta = ts - base_ns;
+			rot->readings[n].x = EMUL_IMU_ROT_Q31(entry[i].v[0]);
+			rot->readings[n].y = EMUL_IMU_ROT_Q31(entry[i].v[1]);
+			rot->readings[n].z = EMUL_IMU_ROT_Q31(entry[i].v[2]);
+			rot->readings[n].w = EMUL_IMU_ROT_Q31(emul_imu_rot_w(entry[i].v));
+			break;
+		default:
+			q31->readings[n].timestamp_delta = ts - base_ns;
+			q31->readings[n].temperature = EMUL_IMU_TEMP_Q31(entry[i].v[0]);
+			break;
+		}
+
+		n++;
+		*fit = i + 1;
+	}
+
+	if (n == 0) {
+		return 0;
+	}
+
+	if (tag == EMUL_IMU_TAG_TEMP) {
+		q31->header.base_timestamp_ns = base_ns;
+		q31->header.reading_count = n;
+		q31->shift = EMUL_IMU_TEMP_SHIFT;
+	} else if (tag == EMUL_IMU_TAG_ROT) {
+		rot->header.base_timestamp_ns = base_ns;
+		rot->header.reading_count = n;
+		rot->shift = EMUL_IMU_ROT_SHIFT;
+	} else {
+		xyz->header.base_timestamp_ns = base_ns;
+		xyz->header.reading_count = n;
+		xyz->shift = (tag == EMUL_IMU_TAG_GY) ? EMUL_IMU_GY_SHIFT : EMUL_IMU_XL_SHIFT;
+	}
+
+	return n;
+}
+
+static bool emul_imu_decoder_has_trigger(const uint8_t *buffer, enum sensor_trigger_type trigger)
+{
+	const struct emul_imu_header *hdr = (const struct emul_imu_header *)buffer;
+
+	return (trigger < 32) && (hdr->triggers & BIT(trigger)) != 0;
+}
+
+SENSOR_DECODER_API_DT_DEFINE() = {
+	.get_frame_count = emul_imu_decoder_get_frame_count,
+	.get_size_info = emul_imu_decoder_get_size_info,
+	.decode = emul_imu_decoder_decode,
+	.has_trigger = emul_imu_decoder_has_trigger,
+};
+
+static int emul_imu_get_decoder(const struct device *dev,
+				const struct sensor_decoder_api **decoder)
+{
+	ARG_UNUSED(dev);
+	*decoder = &SENSOR_DECODER_NAME();
+
+	return 0;
+}
+
+static const struct sensor_driver_api emul_imu_api = {
+	.attr_set = emul_imu_attr_set,
+	.attr_get = emul_imu_attr_get,
+	.submit = emul_imu_submit,
+	.get_decoder = emul_imu_get_decoder,
+};
+
+static int emul_imu_init(const struct device *dev)
+{
+	const struct emul_imu_config *cfg = dev->config;
+	struct emul_imu_data *data = dev->data;
+
+	data->dev = dev;
+	data->rng = 0x1234567 + (uintptr_t)dev;
+	data->watermark = cfg->watermark;
+
+	k_timer_init(&data->timer, emul_imu_timer_handler, NULL);
+	emul_imu_start(dev, cfg->odr_hz);
+
+	return 0;
+}
+
+#define EMUL_IMU_DEFINE(inst)								\
+	static struct emul_imu_data emul_imu_data_##inst;				\
+											\
+	static const struct emul_imu_config emul_imu_config_##inst = {			\
+		.odr_hz = DT_INST_PROP(inst, odr_hz),					\
+		.watermark = DT_INST_PROP(inst, fifo_watermark),			\
+		.temp_divider = DT_INST_PROP(inst, temp_divider),			\
+		.drift_ppb = (int32_t)DT_INST_PROP(inst, drift_ppb),			\
+		.offset_ns = (int64_t)DT_INST_PROP(inst, offset_us) * NSEC_PER_USEC,	\
+		.motion_amplitude_deg = DT_INST_PROP(inst, motion_amplitude_deg),	\
+		.motion_period_ms = DT_INST_PROP(inst, motion_period_ms),		\
+		.sflp_divider = DT_INST_PROP(inst, sflp_divider),			\
+	};										\
+											\
+	SENSOR_DEVICE_DT_INST_DEFINE(inst, emul_imu_init, NULL,				\
+				     &emul_imu_data_##inst, &emul_imu_config_##inst,	\
+				     POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY,		\
+				     &emul_imu_api);
+
+DT_INST_FOREACH_STATUS_OKAY(EMUL_IMU_DEFINE)
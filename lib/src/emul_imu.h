@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EMUL_IMU_H_
+#define EMUL_IMU_H_
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+
+/*
+ * FIFO watermark in entries, for sensor_attr_set() and sensor_attr_get()
+ * on any channel. The output data rate is set with
+ * SENSOR_ATTR_SAMPLING_FREQUENCY; changing it restarts the sample counter
+ * and flushes the FIFO.
+ */
+#define EMUL_IMU_ATTR_FIFO_WATERMARK SENSOR_ATTR_PRIV_START
+
+/**
+ * @brief Convert an emulated sensor clock timestamp to system uptime.
+ *
+ * Uses the offset and drift injected through devicetree, so it gives the
+ * true sampling instant of a frame against which timestamp alignment can
+ * be measured.
+ *
+ * @param dev Emulated IMU device
+ * @param sensor_ns Timestamp in the sensor clock (ns)
+ * @param uptime_ns Sampling instant in system uptime (ns)
+ * @return 0 on success, -ENODEV if @p dev is not an emulated IMU
+ */
+int emul_imu_to_uptime_ns(const struct device *dev, uint64_t sensor_ns, uint64_t *uptime_ns);
+
+/**
+ * @brief Number of FIFO entries lost because the FIFO was full.
+ */
+uint32_t emul_imu_overruns(const struct device *dev);
+
+/**
+ * @brief CPU cycles spent completing stream requests.
+ *
+ * Counts what a driver would do on the FIFO or data ready interrupt:
+ * copying the FIFO into the request buffer and completing it, which can
+ * resubmit a multishot request. Generating the samples stands in for the
+ * sensor and is not counted. The counter is in k_cycle_get_32() units and
+ * wraps around, take differences.
+ */
+uint32_t emul_imu_completion_cycles(const struct device *dev);
+
+#endif /* EMUL_IMU_H_ */
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_SAMPLE_H_
+#define IMU_SAMPLE_H_
+
+#include <stdint.h>
+
+#include <zephyr/dsp/types.h>
+
+/* One decoded frame: x, y, z (and w for rotation vectors) or a scalar in v[0] */
+struct imu_sample {
+	uint64_t timestamp_ns;
+	q31_t v[4];
+};
+
+#endif /* IMU_SAMPLE_H_ */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/bitarray.h>
+#include <zephyr/sys/mem_blocks.h>
+
+#include "mempool_stats.h"
+
+static void mempool_stats_sample(struct mempool_stats *stats)
+{
+	sys_mem_blocks_t *pool = stats->r->block_pool;
+	uint32_t used = 0, run = 0, largest_run = 0;
+
+	for (uint32_t i = 0; i < stats->num_blocks; i++) {
+		int bit = 0;
+
+		sys_bitarray_test_bit(pool->bitmap, i, &bit);
+		if (bit) {
+			used++;
+			run = 0;
+		} else {
+			run++;
+			largest_run = MAX(largest_run, run);
+		}
+	}
+
+	stats->in_use = used;
+	stats->largest_free_run = largest_run;
+	stats->high_water = MAX(stats->high_water, used);
+
+#ifdef CONFIG_SYS_MEM_BLOCKS_RUNTIME_STATS
+	struct sys_memory_stats mem;
+
+	/* the pool keeps an exact peak, our samples could miss short bursts */
+	if (sys_mem_blocks_runtime_stats_get(pool, &mem) == 0) {
+		stats->high_water = MAX(stats->high_water,
+					mem.max_allocated_bytes / stats->block_size);
+	}
+#endif
+}
+
+void mempool_stats_init(struct mempool_stats *stats, struct rtio *r, const char *name)
+{
+	*stats = (struct mempool_stats){ 0 };
+	stats->r = r;
+	stats->name = name;
+	stats->num_blocks = r->block_pool->info.num_blocks;
+	stats->block_size = rtio_mempool_block_size(r);
+
+	mempool_stats_sample(stats);
+}
+
+void mempool_stats_on_cqe(struct mempool_stats *stats, int result, uint32_t buf_len)
+{
+	if (result == -ENOMEM) {
+		stats->alloc_failures++;
+	}
+
+	if (buf_len > 0) {
+		stats->buffers++;
+		stats->max_buf_blocks = MAX(stats->max_buf_blocks,
+					    DIV_ROUND_UP(buf_len, stats->block_size));
+	}
+
+	mempool_stats_sample(stats);
+}
+
+uint32_t mempool_stats_fragmentation(const struct mempool_stats *stats)
+{
+	uint32_t free_blocks = stats->num_blocks - stats->in_use;
+
+	if (free_blocks == 0) {
+		return 0;
+	}
+
+	return 100 - (stats->largest_free_run * 100) / free_blocks;
+}
+
+void mempool_stats_print(const struct mempool_stats *stats)
+{
+	printk("%s mempool: %u/%u blocks of %uB in use, high-water %u, "
+	       "largest free run %u, fragmentation %u%%, "
+	       "max buffer %u blocks, buffers %u, alloc failures %u\n",
+	       stats->name, stats->in_use, stats->num_blocks, stats->block_size,
+	       stats->high_water, stats->largest_free_run,
+	       mempool_stats_fragmentation(stats), stats->max_buf_blocks,
+	       stats->buffers, stats->alloc_failures);
+}
+
+uint32_t mempool_recommend_blocks(uint16_t watermark, const struct mempool_fifo_mix *mix,
+				  uint32_t latency_us, uint32_t block_size)
+{
+	uint32_t rate_hz = mix->xl_hz + mix->gy_hz + mix->temp_hz +
+			   mix->sflp_hz * mix->sflp_outputs;
+	uint32_t late_entries = DIV_ROUND_UP(rate_hz * latency_us, USEC_PER_SEC);
+
+	return 2 * MEMPOOL_DRAIN_BLOCKS(watermark + late_entries, block_size);
+}
+
+uint16_t mempool_lsm6dsv16x_batch_hz(uint8_t code)
+{
+	/* 1 -> 1.875 Hz, 2 -> 7.5 Hz, then doubling up to 7680 Hz */
+	if (code == 0) {
+		return 0;
+	}
+
+	if (code == 1) {
+		return 2;
+	}
+
+	return (15U << (code - 2)) / 2;
+}
+
+uint16_t mempool_lsm6dsv16x_temp_hz(uint8_t code)
+{
+	static const uint16_t temp_hz[] = { 0, 2, 15, 60 };
+
+	return (code < ARRAY_SIZE(temp_hz)) ? temp_hz[code] : 0;
+}
+
+uint16_t mempool_lsm6dsv16x_sflp_hz(uint8_t code)
+{
+	/* 0 -> 15 Hz, doubling up to 480 Hz */
+	return 15U << code;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef MEMPOOL_STATS_H_
+#define MEMPOOL_STATS_H_
+
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/util.h>
+
+/* Size of one FIFO entry (tag byte + 6 data bytes) as copied by the driver */
+#define MEMPOOL_FIFO_ENTRY_SIZE 7
+
+/* Upper bound of the driver header prepended to every FIFO drain buffer */
+#define MEMPOOL_FIFO_HEADER_SIZE 32
+
+/* Bytes and contiguous mempool blocks needed by a drain of @p wm entries */
+#define MEMPOOL_DRAIN_SIZE(wm) (MEMPOOL_FIFO_HEADER_SIZE + (wm) * MEMPOOL_FIFO_ENTRY_SIZE)
+#define MEMPOOL_DRAIN_BLOCKS(wm, blk_size) DIV_ROUND_UP(MEMPOOL_DRAIN_SIZE(wm), (blk_size))
+
+/* FIFO batch rates (Hz) of the channels enabled on one sensor */
+struct mempool_fifo_mix {
+	uint16_t xl_hz;
+	uint16_t gy_hz;
+	uint16_t temp_hz;
+	uint16_t sflp_hz;
+	/* number of SFLP outputs (game rotation, gravity, gbias) in the FIFO */
+	uint8_t sflp_outputs;
+};
+
+struct mempool_stats {
+	struct rtio *r;
+	const char *name;
+	uint32_t num_blocks;
+	uint32_t block_size;
+	/* blocks allocated at the last sample */
+	uint32_t in_use;
+	/* highest number of blocks ever allocated at the same time */
+	uint32_t high_water;
+	/* largest run of contiguous free blocks at the last sample */
+	uint32_t largest_free_run;
+	/* largest single buffer (in blocks) handed to the application */
+	uint32_t max_buf_blocks;
+	uint32_t buffers;
+	uint32_t alloc_failures;
+};
+
+/**
+ * @brief Attach telemetry to the mempool of an RTIO context.
+ */
+void mempool_stats_init(struct mempool_stats *stats, struct rtio *r, const char *name);
+
+/**
+ * @brief Account a completion on the RTIO context.
+ *
+ * Must be called while the mempool buffer of the completion (if any) is
+ * still held, so that the sampled occupancy includes it.
+ *
+ * @param result CQE result, -ENOMEM marks a failed buffer allocation
+ * @param buf_len Length of the mempool buffer, 0 if none
+ */
+void mempool_stats_on_cqe(struct mempool_stats *stats, int result, uint32_t buf_len);
+
+/**
+ * @brief Fragmentation of the free space in percent.
+ *
+ * 0 means all free blocks are contiguous, values close to 100 mean no
+ * multi-block buffer can be allocated even though blocks are free.
+ */
+uint32_t mempool_stats_fragmentation(const struct mempool_stats *stats);
+
+void mempool_stats_print(const struct mempool_stats *stats);
+
+/**
+ * @brief Recommend the number of mempool blocks for one streaming sensor.
+ *
+ * One drain holds the watermark entries plus whatever the enabled channels
+ * batch while the FIFO is being read. Two drains per sensor are kept in
+ * flight: one held by the application, one being filled by the driver.
+ *
+ * @param watermark FIFO watermark (entries)
+ * @param mix FIFO batch rates of the enabled channels
+ * @param latency_us Time between the watermark interrupt and the FIFO read
+ * @param block_size Mempool block size in bytes
+ * @return Recommended number of blocks for this sensor
+ */
+uint32_t mempool_recommend_blocks(uint16_t watermark, const struct mempool_fifo_mix *mix,
+				  uint32_t latency_us, uint32_t block_size);
+
+/* LSM6DSV16X devicetree batch rate codes to Hz (0 when not batched) */
+uint16_t mempool_lsm6dsv16x_batch_hz(uint8_t code);
+uint16_t mempool_lsm6dsv16x_temp_hz(uint8_t code);
+uint16_t mempool_lsm6dsv16x_sflp_hz(uint8_t code);
+
+#endif /* MEMPOOL_STATS_H_ */
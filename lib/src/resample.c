@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "resample.h"
+
+static uint32_t resample_gcd(uint32_t a, uint32_t b)
+{
+	while (b != 0) {
+		uint32_t t = a % b;
+
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+void resample_ratio(uint32_t in_hz, uint32_t out_hz, uint16_t *up, uint16_t *down)
+{
+	uint32_t g = resample_gcd(in_hz, out_hz);
+
+	*up = out_hz / g;
+	*down = in_hz / g;
+}
+
+static float resample_tap(uint16_t i, uint16_t taps, float fc)
+{
+	float center = (taps - 1) / 2.0f;
+	float x = 2.0f * fc * (i - center);
+	float sinc = (x == 0.0f) ? 1.0f : sinf((float)M_PI * x) / ((float)M_PI * x);
+	float window = (taps > 1) ?
+		0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (taps - 1)) : 1.0f;
+
+	return 2.0f * fc * sinc * window;
+}
+
+/*
+ * Windowed-sinc lowpass with DC gain 'up', stored one polyphase branch after
+ * the other. Computed twice rather than kept in a float buffer the size of
+ * the prototype on the stack.
+ */
+static void resample_design(struct resample *rs)
+{
+	const struct resample_config *cfg = &rs->cfg;
+	uint16_t ntaps = rs->fir.ntaps;
+	uint16_t taps = cfg->up * ntaps;
+	float fc = 0.5f / MAX(cfg->up, cfg->down) * cfg->cutoff_pct / 100.0f;
+	float sum = 0.0f;
+
+	for (uint16_t i = 0; i < taps; i++) {
+		sum += resample_tap(i, taps, fc);
+	}
+
+	for (uint16_t p = 0; p < cfg->up; p++) {
+		for (uint16_t k = 0; k < ntaps; k++) {
+			float q = resample_tap(p + k * cfg->up, taps, fc) * cfg->up / sum * 32768.0f;
+
+			rs->fir.taps[p * ntaps + k] = (q15_t)CLAMP(lroundf(q), INT16_MIN, INT16_MAX);
+		}
+	}
+}
+
+void resample_reset(struct resample *rs)
+{
+	rs->have_ts = false;
+	rs->period_ns = 0;
+
+	if (rs->cfg.type == RESAMPLE_CIC) {
+		memset(rs->cic.integ, 0, sizeof(rs->cic.integ));
+		memset(rs->cic.comb, 0, sizeof(rs->cic.comb));
+		rs->cic.count = 0;
+	} else {
+		memset(rs->fir.hist, 0, sizeof(rs->fir.hist));
+		rs->fir.pos = 0;
+		rs->fir.phase = 0;
+	}
+}
+
+int resample_init(struct resample *rs, const struct resample_config *cfg)
+{
+	if (cfg->channels == 0 || cfg->channels > RESAMPLE_MAX_CHANNELS ||
+	    cfg->up == 0 || cfg->down == 0) {
+		return -EINVAL;
+	}
+
+	memset(rs, 0, sizeof(*rs));
+	rs->cfg = *cfg;
+
+	if (cfg->type == RESAMPLE_CIC) {
+		if (cfg->up != 1 || cfg->order == 0 || cfg->order > RESAMPLE_MAX_ORDER) {
+			return -EINVAL;
+		}
+
+		/* q31 input times the CIC gain must fit in 63 bits */
+		rs->cic.gain = 1;
+		for (uint8_t i = 0; i < cfg->order; i++) {
+			rs->cic.gain *= cfg->down;
+			if (rs->cic.gain > (INT64_MAX >> 32)) {
+				return -EINVAL;
+			}
+		}
+	} else {
+		/* span periods of the lower rate, in taps of the upsampled rate */
+		uint32_t ntaps = DIV_ROUND_UP((uint32_t)cfg->span * MAX(cfg->up, cfg->down),
+					      cfg->up);
+
+		if (cfg->span == 0 || ntaps > RESAMPLE_MAX_PHASE_TAPS ||
+		    cfg->up * ntaps > RESAMPLE_MAX_TAPS ||
+		    cfg->cutoff_pct == 0 || cfg->cutoff_pct > 100) {
+			return -EINVAL;
+		}
+
+		rs->fir.ntaps = ntaps;
+
+		resample_design(rs);
+	}
+
+	resample_reset(rs);
+
+	return 0;
+}
+
+static void resample_track_period(struct resample *rs, uint64_t ts)
+{
+	if (rs->have_ts && ts > rs->last_ts) {
+		rs->period_ns = ts - rs->last_ts;
+	}
+
+	rs->last_ts = ts;
+	rs->have_ts = true;
+}
+
+static uint16_t resample_process_cic(struct resample *rs, const struct imu_sample *in,
+				     uint16_t count, struct imu_sample *out, uint16_t out_max)
+{
+	const struct resample_config *cfg = &rs->cfg;
+	uint16_t n = 0;
+
+	for (uint16_t i = 0; i < count; i++) {
+		resample_track_period(rs, in[i].timestamp_ns);
+
+		/* integrators wrap around, the combs undo it exactly */
+		for (uint8_t c = 0; c < cfg->channels; c++) {
+			rs->cic.integ[0][c] += (uint64_t)(int64_t)in[i].v[c];
+			for (uint8_t s = 1; s < cfg->order; s++) {
+				rs->cic.integ[s][c] += rs->cic.integ[s - 1][c];
+			}
+		}
+
+		if (++rs->cic.count < cfg->down) {
+			continue;
+		}
+		rs->cic.count = 0;
+
+		struct imu_sample *o = (n < out_max) ? &out[n] : NULL;
+
+		for (uint8_t c = 0; c < cfg->channels; c++) {
+			uint64_t v = rs->cic.integ[cfg->order - 1][c];
+
+			for (uint8_t s = 0; s < cfg->order; s++) {
+				uint64_t prev = rs->cic.comb[s][c];
+
+				rs->cic.comb[s][c] = v;
+				v -= prev;
+			}
+
+			if (o != NULL) {
+				o->v[c] = (q31_t)((int64_t)v / rs->cic.gain);
+			}
+		}
+
+		if (o != NULL) {
+			for (uint8_t c = cfg->channels; c < ARRAY_SIZE(o->v); c++) {
+				o->v[c] = 0;
+			}
+			o->timestamp_ns = in[i].timestamp_ns -
+				(uint64_t)rs->period_ns * cfg->order * (cfg->down - 1) / 2;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+static uint16_t resample_process_fir(struct resample *rs, const struct imu_sample *in,
+				     uint16_t count, struct imu_sample *out, uint16_t out_max)
+{
+	const struct resample_config *cfg = &rs->cfg;
+	uint16_t ntaps = rs->fir.ntaps;
+	uint16_t n = 0;
+
+	for (uint16_t i = 0; i < count; i++) {
+		resample_track_period(rs, in[i].timestamp_ns);
+
+		rs->fir.pos = (rs->fir.pos + 1) % ntaps;
+		for (uint8_t c = 0; c < cfg->channels; c++) {
+			rs->fir.hist[c][rs->fir.pos] = in[i].v[c];
+			rs->fir.hist[c][rs->fir.pos + ntaps] = in[i].v[c];
+		}
+
+		/* outputs falling between this input and the next one */
+		while (rs->fir.phase < cfg->up) {
+			const q15_t *taps = &rs->fir.taps[rs->fir.phase * ntaps];
+
+			if (n < out_max) {
+				struct imu_sample *o = &out[n];
+				uint32_t delay_ns = (uint64_t)rs->period_ns *
+						    (cfg->up * ntaps - 1) / (2 * cfg->up);
+
+				for (uint8_t c = 0; c < cfg->channels; c++) {
+					/* newest sample is at pos + ntaps, going back in time */
+					const q31_t *x = &rs->fir.hist[c][rs->fir.pos + ntaps];
+					int64_t acc = 0;
+
+					for (uint16_t k = 0; k < ntaps; k++) {
+						acc += (int64_t)taps[k] * x[-k];
+					}
+
+					o->v[c] = (q31_t)CLAMP(acc >> 15, INT32_MIN, INT32_MAX);
+				}
+
+				for (uint8_t c = cfg->channels; c < ARRAY_SIZE(o->v); c++) {
+					o->v[c] = 0;
+				}
+
+				o->timestamp_ns = in[i].timestamp_ns - delay_ns +
+					(uint64_t)rs->period_ns * rs->fir.phase / cfg->up;
+				n++;
+			}
+
+			rs->fir.phase += cfg->down;
+		}
+
+		rs->fir.phase -= cfg->up;
+	}
+
+	return n;
+}
+
+uint16_t resample_process(struct resample *rs, const struct imu_sample *in, uint16_t count,
+			  struct imu_sample *out, uint16_t out_max)
+{
+	if (rs->cfg.type == RESAMPLE_CIC) {
+		return resample_process_cic(rs, in, count, out, out_max);
+	}
+
+	return resample_process_fir(rs, in, count, out, out_max);
+}
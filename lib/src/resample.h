@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef RESAMPLE_H_
+#define RESAMPLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+#define RESAMPLE_MAX_CHANNELS	4
+#define RESAMPLE_MAX_ORDER	5
+#define RESAMPLE_MAX_PHASE_TAPS	CONFIG_IMU_LIB_RESAMPLE_MAX_PHASE_TAPS
+#define RESAMPLE_MAX_TAPS	CONFIG_IMU_LIB_RESAMPLE_MAX_TAPS
+
+enum resample_type {
+	/* cascaded integrator-comb, integer decimation only */
+	RESAMPLE_CIC,
+	/* polyphase FIR, rational up/down ratio */
+	RESAMPLE_FIR,
+};
+
+struct resample_config {
+	enum resample_type type;
+	/* output rate = input rate * up / down, up must be 1 for CIC */
+	uint16_t up;
+	uint16_t down;
+	/* CIC: number of integrator and comb stages */
+	uint8_t order;
+	/*
+	 * FIR: prototype length in periods of the lower of the two rates, so the
+	 * transition band keeps the same width relative to the cutoff whatever
+	 * the ratio. Each polyphase branch has span * max(up, down) / up taps,
+	 * rounded up.
+	 */
+	uint8_t span;
+	/* FIR: anti-aliasing cutoff in percent of the lower of the two Nyquist rates */
+	uint8_t cutoff_pct;
+	/* number of v[] values filtered in each imu_sample */
+	uint8_t channels;
+};
+
+/*
+ * Streaming resampler state. Samples can be fed in batches of any size,
+ * the filter state and the output phase are kept from one call to the next.
+ */
+struct resample {
+	struct resample_config cfg;
+	uint64_t last_ts;
+	uint32_t period_ns;
+	bool have_ts;
+
+	union {
+		struct {
+			uint64_t integ[RESAMPLE_MAX_ORDER][RESAMPLE_MAX_CHANNELS];
+			uint64_t comb[RESAMPLE_MAX_ORDER][RESAMPLE_MAX_CHANNELS];
+			int64_t gain;
+			uint16_t count;
+		} cic;
+		struct {
+			/* taps[p][k] = h[p + k * up], so every branch is contiguous */
+			q15_t taps[RESAMPLE_MAX_TAPS];
+			/* history stored twice to read it without wrapping */
+			q31_t hist[RESAMPLE_MAX_CHANNELS][2 * RESAMPLE_MAX_PHASE_TAPS];
+			/* taps per polyphase branch */
+			uint16_t ntaps;
+			uint16_t pos;
+			/* position of the next output in the upsampled domain */
+			uint16_t phase;
+		} fir;
+	};
+};
+
+/**
+ * @brief Initialize a resampler.
+ *
+ * For FIR resampling a windowed-sinc anti-aliasing lowpass is designed
+ * for the requested ratio.
+ *
+ * @return 0 on success, -EINVAL if the configuration is not supported
+ */
+int resample_init(struct resample *rs, const struct resample_config *cfg);
+
+/* Clear the filter state, keeping the configuration */
+void resample_reset(struct resample *rs);
+
+/**
+ * @brief Feed input samples and collect the resampled output.
+ *
+ * Output timestamps are interpolated from the input ones and corrected
+ * for the group delay of the filter.
+ *
+ * @param in Input samples in time order
+ * @param count Number of input samples
+ * @param out Output samples
+ * @param out_max Capacity of @p out, further outputs are discarded
+ * @return Number of output samples written
+ */
+uint16_t resample_process(struct resample *rs, const struct imu_sample *in, uint16_t count,
+			  struct imu_sample *out, uint16_t out_max);
+
+/* Reduce out_hz / in_hz to the smallest up / down ratio */
+void resample_ratio(uint32_t in_hz, uint32_t out_hz, uint16_t *up, uint16_t *down);
+
+#endif /* RESAMPLE_H_ */
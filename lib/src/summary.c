@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdarg.h>
+#include <string.h>
+
+#include <zephyr/dsp/print_format.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+
+#include "summary.h"
+
+void summary_window_reset(struct summary_window *win, const char *name,
+			  const char *const *chan_names, uint8_t num_chans)
+{
+	memset(win, 0, sizeof(*win));
+	win->name = name;
+	win->chan_names = chan_names;
+	win->num_chans = MIN(num_chans, SUMMARY_MAX_CHANNELS);
+}
+
+void summary_add(struct summary_window *win, uint8_t chan, const struct imu_sample *samples,
+		 uint16_t count, uint8_t values, int8_t shift)
+{
+	struct summary_chan *c = &win->chan[chan];
+
+	if (count == 0 || chan >= win->num_chans) {
+		return;
+	}
+
+	if (c->count == 0) {
+		c->values = MIN(values, SUMMARY_MAX_VALUES);
+		c->shift = shift;
+		c->first_ns = samples[0].timestamp_ns;
+		for (uint8_t v = 0; v < c->values; v++) {
+			c->min[v] = INT32_MAX;
+			c->max[v] = INT32_MIN;
+		}
+	}
+
+	for (uint16_t i = 0; i < count; i++) {
+		for (uint8_t v = 0; v < c->values; v++) {
+			q31_t x = samples[i].v[v];
+			int32_t r = x >> SUMMARY_SQ_SHIFT;
+
+			c->min[v] = MIN(c->min[v], x);
+			c->max[v] = MAX(c->max[v], x);
+			c->sum[v] += x;
+			c->sum_sq[v] += (int64_t)r * r;
+		}
+	}
+
+	c->count += count;
+	c->last_ns = samples[count - 1].timestamp_ns;
+}
+
+q31_t summary_mean(const struct summary_chan *c, uint8_t v)
+{
+	return (c->count == 0) ? 0 : (q31_t)(c->sum[v] / (int64_t)c->count);
+}
+
+static uint32_t summary_isqrt(uint64_t x)
+{
+	uint64_t r = 0, bit = 1ULL << 62;
+
+	while (bit > x) {
+		bit >>= 2;
+	}
+
+	while (bit != 0) {
+		if (x >= r + bit) {
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint32_t)r;
+}
+
+q31_t summary_rms(const struct summary_chan *c, uint8_t v)
+{
+	uint64_t rms;
+
+	if (c->count == 0) {
+		return 0;
+	}
+
+	rms = (uint64_t)summary_isqrt(c->sum_sq[v] / c->count) << SUMMARY_SQ_SHIFT;
+
+	return (q31_t)MIN(rms, INT32_MAX);
+}
+
+static void summary_append(char *buf, size_t len, size_t *pos, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (*pos >= len - 1) {
+		return;
+	}
+
+	va_start(ap, fmt);
+	n = vsnprintk(buf + *pos, len - *pos, fmt, ap);
+	va_end(ap);
+
+	if (n > 0) {
+		*pos = MIN(*pos + n, len - 1);
+	}
+}
+
+static void summary_append_values(char *buf, size_t len, size_t *pos, const char *label,
+				  const struct summary_chan *c, const q31_t *q)
+{
+	summary_append(buf, len, pos, " %s (", label);
+	for (uint8_t v = 0; v < c->values; v++) {
+		summary_append(buf, len, pos, "%s%" PRIq(3), (v == 0) ? "" : ", ",
+			       PRIq_arg(q[v], 3, c->shift));
+	}
+	summary_append(buf, len, pos, ")");
+}
+
+int summary_format(const struct summary_window *win, char *buf, size_t len)
+{
+	uint64_t first_ns = UINT64_MAX, last_ns = 0;
+	uint32_t frames = 0;
+	size_t pos = 0;
+
+	if (len == 0) {
+		return 0;
+	}
+	buf[0] = '\0';
+
+	for (uint8_t i = 0; i < win->num_chans; i++) {
+		const struct summary_chan *c = &win->chan[i];
+
+		if (c->count > 0) {
+			frames += c->count;
+			first_ns = MIN(first_ns, c->first_ns);
+			last_ns = MAX(last_ns, c->last_ns);
+		}
+	}
+
+	summary_append(buf, len, &pos, "summary %s: %u events, %u frames", win->name,
+		       win->events, frames);
+	if (frames > 0) {
+		summary_append(buf, len, &pos, ", %llu..%llu ns", first_ns, last_ns);
+	}
+	if (win->dropped > 0) {
+		summary_append(buf, len, &pos, ", %u dropped", win->dropped);
+	}
+	if (win->lost > 0) {
+		summary_append(buf, len, &pos, ", %u windows lost", win->lost);
+	}
+
+	for (uint8_t i = 0; i < win->num_chans; i++) {
+		const struct summary_chan *c = &win->chan[i];
+		q31_t mean[SUMMARY_MAX_VALUES], rms[SUMMARY_MAX_VALUES];
+
+		if (c->count == 0) {
+			continue;
+		}
+
+		for (uint8_t v = 0; v < c->values; v++) {
+			mean[v] = summary_mean(c, v);
+			rms[v] = summary_rms(c, v);
+		}
+
+		summary_append(buf, len, &pos, " | %s %u", win->chan_names[i], c->count);
+		summary_append_values(buf, len, &pos, "mean", c, mean);
+		summary_append_values(buf, len, &pos, "rms", c, rms);
+		summary_append_values(buf, len, &pos, "min", c, c->min);
+		summary_append_values(buf, len, &pos, "max", c, c->max);
+	}
+
+	return pos;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SUMMARY_H_
+#define SUMMARY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+#define SUMMARY_MAX_CHANNELS	6
+#define SUMMARY_MAX_VALUES	4
+
+/*
+ * Squares are accumulated on q31 values shifted right by this amount, so
+ * that 2^26 full-scale frames fit in the 64-bit sum.
+ */
+#define SUMMARY_SQ_SHIFT	12
+
+/* Running statistics of one channel, all values in the q31 format of the decoder */
+struct summary_chan {
+	uint32_t count;
+	/* number of v[] values tracked, 0 until the first frame */
+	uint8_t values;
+	int8_t shift;
+	uint64_t first_ns;
+	uint64_t last_ns;
+	q31_t min[SUMMARY_MAX_VALUES];
+	q31_t max[SUMMARY_MAX_VALUES];
+	int64_t sum[SUMMARY_MAX_VALUES];
+	uint64_t sum_sq[SUMMARY_MAX_VALUES];
+};
+
+/* Statistics of all channels of one sensor over a window of FIFO events */
+struct summary_window {
+	const char *name;
+	/* arrival time of the first and last event of the window */
+	uint64_t start_ns;
+	uint64_t end_ns;
+	uint32_t events;
+	/* frames the acquisition side could not store */
+	uint32_t dropped;
+	/* windows that could not be handed to the formatter before this one */
+	uint32_t lost;
+	const char *const *chan_names;
+	uint8_t num_chans;
+	struct summary_chan chan[SUMMARY_MAX_CHANNELS];
+};
+
+void summary_window_reset(struct summary_window *win, const char *name,
+			  const char *const *chan_names, uint8_t num_chans);
+
+/**
+ * @brief Accumulate frames of one channel.
+ *
+ * Cheap enough to run on the acquisition thread: a compare, an add and a
+ * multiply per value, no division.
+ *
+ * @param samples Frames in time order
+ * @param count Number of frames
+ * @param values Number of v[] values per frame (1 to SUMMARY_MAX_VALUES)
+ * @param shift Decoder shift of the q31 values, taken from the first frames
+ */
+void summary_add(struct summary_window *win, uint8_t chan, const struct imu_sample *samples,
+		 uint16_t count, uint8_t values, int8_t shift);
+
+/* Mean and RMS of value @p v of a channel, in the q31 format of the channel */
+q31_t summary_mean(const struct summary_chan *c, uint8_t v);
+q31_t summary_rms(const struct summary_chan *c, uint8_t v);
+
+/**
+ * @brief Format a window as a single line.
+ *
+ * Lists per channel the frame count, mean, RMS, min and max of every value
+ * and the timestamp span of the frames.
+ *
+ * @return Number of characters written, truncated to @p len - 1
+ */
+int summary_format(const struct summary_window *win, char *buf, size_t len);
+
+#endif /* SUMMARY_H_ */
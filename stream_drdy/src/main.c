@@ -14,6 +14,14 @@
 #include <zephyr/rtio/rtio.h>
 #include <zephyr/drivers/sensor.h>
 
+#ifdef CONFIG_STREAM_DRDY_OUTPUT_SUMMARY
+#include "summary.h"
+#endif
+
+#ifdef CONFIG_STREAM_DRDY_BUS_PROF
+#include "bus_prof.h"
+#endif
+
 #define STREAMDEV_ALIAS(i) DT_ALIAS(_CONCAT(stream, i))
 #define STREAMDEV_DEVICE(i, _) \
 	IF_ENABLED(DT_NODE_EXISTS(STREAMDEV_ALIAS(i)), (DEVICE_DT_GET(STREAMDEV_ALIAS(i)),))
@@ -46,6 +54,74 @@ struct sensor_chan_spec accel_chan = { SENSOR_CHAN_ACCEL_XYZ, 0 };
 static uint8_t accel_buf[128] = { 0 };
 static uint32_t tot_frame_count = 0;
 
+#ifdef CONFIG_STREAM_DRDY_OUTPUT_SUMMARY
+static const char *const summary_chan_name[] = { "XL" };
+static struct summary_window summary;
+static uint32_t summary_lost;
+
+K_MSGQ_DEFINE(summary_msgq, sizeof(struct summary_window),
+	      CONFIG_STREAM_DRDY_SUMMARY_QUEUE_DEPTH, 8);
+
+/* Formats and prints the summaries, so console I/O stays off the acquisition thread */
+static void summary_thread(void *p1, void *p2, void *p3)
+{
+	static struct summary_window win;
+	static char line[256];
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (1) {
+		k_msgq_get(&summary_msgq, &win, K_FOREVER);
+		summary_format(&win, line, sizeof(line));
+		printk("%s\n", line);
+	}
+}
+
+K_THREAD_DEFINE(summary_tid, CONFIG_STREAM_DRDY_SUMMARY_STACK_SIZE, summary_thread,
+		NULL, NULL, NULL, CONFIG_STREAM_DRDY_SUMMARY_PRIORITY, 0, 0);
+
+static void summary_frames(const struct device *dev, const struct sensor_three_axis_data *data,
+			   int count)
+{
+	uint64_t now_ns = k_ticks_to_ns_floor64(k_uptime_ticks());
+
+	if (summary.events == 0) {
+		summary_window_reset(&summary, dev->name, summary_chan_name, 1);
+		summary.start_ns = now_ns;
+	}
+
+	for (int k = 0; k < count; k++) {
+		struct imu_sample s = {
+			.timestamp_ns = data->header.base_timestamp_ns +
+					data->readings[k].timestamp_delta,
+			.v = { data->readings[k].x, data->readings[k].y, data->readings[k].z },
+		};
+
+		summary_add(&summary, 0, &s, 1, 3, data->shift);
+	}
+
+	summary.events++;
+	summary.end_ns = now_ns;
+
+	if (summary.end_ns - summary.start_ns <
+	    (uint64_t)CONFIG_STREAM_DRDY_SUMMARY_WINDOW_MS * NSEC_PER_MSEC) {
+		return;
+	}
+
+	/* never block acquisition on the console, count what the formatter missed */
+	summary.lost = summary_lost;
+	if (k_msgq_put(&summary_msgq, &summary, K_NO_WAIT) == 0) {
+		summary_lost = 0;
+	} else {
+		summary_lost++;
+	}
+
+	summary.events = 0;
+}
+#endif /* CONFIG_STREAM_DRDY_OUTPUT_SUMMARY */
+
 static int print_accels_stream(const struct device *dev, struct rtio_iodev *iodev)
 {
 	int rc = 0;
@@ -115,9 +191,13 @@ static int print_accels_stream(const struct device *dev, struct rtio_iodev *iode
 		/* decode and print Accelerometer frames */
 		c = decoder->decode(buf, accel_chan, &accel_fit, 1, accel_data);
 
+#ifdef CONFIG_STREAM_DRDY_OUTPUT_SUMMARY
+		summary_frames(dev, accel_data, c);
+#else
 		printk("XL data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
 		       ", %" PRIq(6) ")\n", dev->name,
 		       PRIsensor_three_axis_data_arg(*accel_data, 0));
+#endif
 
 		rtio_release_buffer(&stream_ctx, buf, buf_len);
 	}
@@ -152,6 +232,10 @@ int main(void)
 		check_sensor_is_off(sensors[i]);
 	}
 
+#ifdef CONFIG_STREAM_DRDY_BUS_PROF
+	bus_prof_init(CONFIG_STREAM_DRDY_BUS_PROF_INTERVAL_MS);
+#endif
+
 	while (1) {
 		for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
 			ret = print_accels_stream(sensors[i], iodevs[i]);
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "clock_align.h"
+
+#define WINDOW_NS ((uint64_t)CONFIG_STREAM_FIFO_CLOCK_ALIGN_WINDOW_MS * NSEC_PER_MSEC)
+#define LATENCY_NS ((uint64_t)CONFIG_STREAM_FIFO_CLOCK_ALIGN_LATENCY_US * NSEC_PER_USEC)
+
+void clock_align_init(struct clock_align *ca)
+{
+	*ca = (struct clock_align){ 0 };
+}
+
+static int64_t clock_align_delay(uint64_t sensor_ns, uint64_t uptime_ns)
+{
+	return (int64_t)(uptime_ns - sensor_ns);
+}
+
+/* Point @p i of the fit: closed windows oldest first, then the current one */
+static void clock_align_point(const struct clock_align *ca, uint8_t i,
+			      uint64_t *sensor_ns, uint64_t *uptime_ns)
+{
+	if (i < ca->win_count) {
+		uint8_t idx = (ca->win_head + ARRAY_SIZE(ca->win_sensor_ns) - ca->win_count + i) %
+			      ARRAY_SIZE(ca->win_sensor_ns);
+
+		*sensor_ns = ca->win_sensor_ns[idx];
+		*uptime_ns = ca->win_uptime_ns[idx];
+	} else {
+		*sensor_ns = ca->cur_sensor_ns;
+		*uptime_ns = ca->cur_uptime_ns;
+	}
+}
+
+static void clock_align_fit(struct clock_align *ca)
+{
+	uint8_t n = ca->win_count + (ca->cur_valid ? 1 : 0);
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	double a, b, den, lowest = 0;
+	uint64_t s0, u0, s, u;
+
+	if (n == 0) {
+		return;
+	}
+
+	/*
+	 * Fit y = a + b * x relative to the oldest point, where y is the
+	 * residual against a drift-free clock, to keep the numbers small.
+	 */
+	clock_align_point(ca, 0, &s0, &u0);
+
+	for (uint8_t i = 0; i < n; i++) {
+		double x, y;
+
+		clock_align_point(ca, i, &s, &u);
+		x = (double)(int64_t)(s - s0);
+		y = (double)((int64_t)(u - u0) - (int64_t)(s - s0));
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+	}
+
+	den = n * sxx - sx * sx;
+	b = (n >= 2 && den > 0) ? (n * sxy - sx * sy) / den : 0;
+	a = (sy - b * sx) / n;
+
+	/* move the line down onto the least delayed point */
+	for (uint8_t i = 0; i < n; i++) {
+		double x, r;
+
+		clock_align_point(ca, i, &s, &u);
+		x = (double)(int64_t)(s - s0);
+		r = (double)((int64_t)(u - u0) - (int64_t)(s - s0)) - (a + b * x);
+		if (i == 0 || r < lowest) {
+			lowest = r;
+		}
+	}
+
+	ca->ref_sensor_ns = s0;
+	ca->ref_uptime_ns = (int64_t)u0 + (int64_t)(a + lowest);
+	ca->drift_ppb = (int64_t)(b * NSEC_PER_SEC);
+	ca->valid = true;
+}
+
+void clock_align_observe(struct clock_align *ca, uint64_t sensor_ns, uint64_t uptime_ns)
+{
+	uptime_ns -= LATENCY_NS;
+
+	if (ca->cur_valid && uptime_ns - ca->cur_start_ns >= WINDOW_NS) {
+		/* close the window, the ring keeps the most recent ones */
+		ca->win_sensor_ns[ca->win_head] = ca->cur_sensor_ns;
+		ca->win_uptime_ns[ca->win_head] = ca->cur_uptime_ns;
+		ca->win_head = (ca->win_head + 1) % ARRAY_SIZE(ca->win_sensor_ns);
+		ca->win_count = MIN(ca->win_count + 1, ARRAY_SIZE(ca->win_sensor_ns));
+		ca->cur_valid = false;
+	}
+
+	if (!ca->cur_valid) {
+		ca->cur_start_ns = uptime_ns;
+		ca->cur_sensor_ns = sensor_ns;
+		ca->cur_uptime_ns = uptime_ns;
+		ca->cur_valid = true;
+	} else if (clock_align_delay(sensor_ns, uptime_ns) <
+		   clock_align_delay(ca->cur_sensor_ns, ca->cur_uptime_ns)) {
+		ca->cur_sensor_ns = sensor_ns;
+		ca->cur_uptime_ns = uptime_ns;
+	} else {
+		return;
+	}
+
+	clock_align_fit(ca);
+}
+
+void clock_align_observe_batch(struct clock_align *ca, const struct imu_batch *batch)
+{
+	uint64_t newest = 0;
+	bool found = false;
+
+	for (int c = 0; c < IMU_CHAN_COUNT; c++) {
+		const struct imu_batch_chan *chan = &batch->chan[c];
+
+		if (chan->count == 0) {
+			continue;
+		}
+
+		newest = MAX(newest, batch->samples[chan->offset + chan->count - 1].timestamp_ns);
+		found = true;
+	}
+
+	if (found) {
+		clock_align_observe(ca, newest, batch->arrival_ns);
+	}
+}
+
+uint64_t clock_align_to_uptime(const struct clock_align *ca, uint64_t sensor_ns)
+{
+	int64_t x = (int64_t)(sensor_ns - ca->ref_sensor_ns);
+
+	if (!ca->valid) {
+		return sensor_ns;
+	}
+
+	return ca->ref_uptime_ns + x + (x * ca->drift_ppb) / (int64_t)NSEC_PER_SEC;
+}
+
+void clock_align_rewrite(const struct clock_align *ca, struct imu_batch *batch)
+{
+	for (int c = 0; c < IMU_CHAN_COUNT; c++) {
+		struct imu_sample *s = imu_batch_samples(batch, c);
+
+		for (uint16_t k = 0; k < batch->chan[c].count; k++) {
+			s[k].timestamp_ns = clock_align_to_uptime(ca, s[k].timestamp_ns);
+		}
+	}
+}
+
+void clock_align_error_add(struct clock_align_error *err, int64_t err_ns)
+{
+	uint64_t abs_ns = (err_ns < 0) ? -err_ns : err_ns;
+
+	err->count++;
+	err->sum_ns += err_ns;
+	err->sum_abs_ns += abs_ns;
+	err->max_abs_ns = MAX(err->max_abs_ns, abs_ns);
+}
+
+void clock_align_error_merge(struct clock_align_error *into,
+			     const struct clock_align_error *from)
+{
+	into->count += from->count;
+	into->sum_ns += from->sum_ns;
+	into->sum_abs_ns += from->sum_abs_ns;
+	into->max_abs_ns = MAX(into->max_abs_ns, from->max_abs_ns);
+}
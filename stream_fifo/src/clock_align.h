@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CLOCK_ALIGN_H_
+#define CLOCK_ALIGN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#include "imu_batch.h"
+
+/*
+ * Mapping of one sensor timestamp base to the system uptime clock:
+ *
+ *   uptime = ref_uptime_ns + x + x * drift_ppb / 1e9,  x = sensor - ref_sensor_ns
+ *
+ * Each FIFO drain gives a (last frame timestamp, arrival uptime) pair whose
+ * uptime is late by an unknown, positive delay. The least delayed pair of
+ * each observation window is kept, a line is fitted through them and then
+ * moved down onto their lower envelope.
+ */
+struct clock_align {
+	uint64_t win_sensor_ns[CONFIG_STREAM_FIFO_CLOCK_ALIGN_WINDOWS];
+	uint64_t win_uptime_ns[CONFIG_STREAM_FIFO_CLOCK_ALIGN_WINDOWS];
+	uint8_t win_head;
+	uint8_t win_count;
+
+	/* least delayed pair of the window being observed */
+	uint64_t cur_start_ns;
+	uint64_t cur_sensor_ns;
+	uint64_t cur_uptime_ns;
+	bool cur_valid;
+
+	uint64_t ref_sensor_ns;
+	int64_t ref_uptime_ns;
+	int64_t drift_ppb;
+	bool valid;
+};
+
+struct clock_align_error {
+	uint32_t count;
+	int64_t sum_ns;
+	uint64_t sum_abs_ns;
+	uint64_t max_abs_ns;
+};
+
+static inline uint64_t clock_align_uptime_ns(void)
+{
+	return k_ticks_to_ns_floor64(k_uptime_ticks());
+}
+
+void clock_align_init(struct clock_align *ca);
+
+/**
+ * @brief Feed the arrival of a FIFO drain.
+ *
+ * @param sensor_ns Timestamp of the newest frame of the drain (sensor clock)
+ * @param uptime_ns System uptime when the drain was received
+ */
+void clock_align_observe(struct clock_align *ca, uint64_t sensor_ns, uint64_t uptime_ns);
+
+/* Feed the newest frame of @p batch against its arrival time */
+void clock_align_observe_batch(struct clock_align *ca, const struct imu_batch *batch);
+
+/* Convert a sensor timestamp to system uptime with the current estimate */
+uint64_t clock_align_to_uptime(const struct clock_align *ca, uint64_t sensor_ns);
+
+/* Rewrite all frame timestamps of @p batch to system uptime */
+void clock_align_rewrite(const struct clock_align *ca, struct imu_batch *batch);
+
+void clock_align_error_add(struct clock_align_error *err, int64_t err_ns);
+
+/* Add the statistics of @p from to @p into */
+void clock_align_error_merge(struct clock_align_error *into,
+			     const struct clock_align_error *from);
+
+#endif /* CLOCK_ALIGN_H_ */
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/time_units.h>
+#include <zephyr/sys/util.h>
+
+#include "fusion.h"
+
+#define Q30_ONE		((int32_t)BIT(30))
+
+/* 9.80665 / 16 in Q20, converts a q30 unit vector to m/s^2 with a shift of 5 */
+#define FUSION_G_Q20	642690
+
+static inline int32_t mul30(int32_t a, int32_t b)
+{
+	return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+static uint32_t fusion_isqrt(uint64_t x)
+{
+	uint64_t r = 0, bit = 1ULL << 62;
+
+	while (bit > x) {
+		bit >>= 2;
+	}
+
+	while (bit != 0) {
+		if (x >= r + bit) {
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint32_t)r;
+}
+
+/* Scale @p n values to a q30 unit vector, false for a null vector */
+static bool fusion_normalize(const int64_t *in, int32_t *out, int n)
+{
+	int64_t t[4];
+	uint64_t max = 0, n2 = 0;
+	int64_t inv;
+	int shift;
+
+	for (int i = 0; i < n; i++) {
+		max = MAX(max, (uint64_t)llabs(in[i]));
+	}
+
+	if (max == 0) {
+		return false;
+	}
+
+	/* bring the largest value to 24 bits so the squares cannot overflow */
+	shift = (63 - u64_count_leading_zeros(max)) - 23;
+
+	for (int i = 0; i < n; i++) {
+		t[i] = (shift >= 0) ? (in[i] >> shift) : (in[i] << -shift);
+		n2 += t[i] * t[i];
+	}
+
+	inv = (int64_t)(BIT64(62) / fusion_isqrt(n2));
+
+	for (int i = 0; i < n; i++) {
+		out[i] = (int32_t)((t[i] * inv) >> 32);
+	}
+
+	return true;
+}
+
+/* Gravity direction in the sensor frame for the quaternion (w, x, y, z) */
+static void fusion_gravity(const int32_t *q, int32_t *v)
+{
+	v[0] = 2 * (mul30(q[1], q[3]) - mul30(q[0], q[2]));
+	v[1] = 2 * (mul30(q[0], q[1]) + mul30(q[2], q[3]));
+	v[2] = mul30(q[0], q[0]) - mul30(q[1], q[1]) - mul30(q[2], q[2]) + mul30(q[3], q[3]);
+}
+
+/* Shortest rotation bringing the measured gravity direction @p u to the z axis */
+static void fusion_init_from_accel(struct fusion *f, const int32_t *u)
+{
+	int64_t q[4] = { (int64_t)Q30_ONE + u[2], u[1], -u[0], 0 };
+
+	if (q[0] < (Q30_ONE >> 10) || !fusion_normalize(q, f->q, 4)) {
+		/* upside down, rotate by 180 degrees around x */
+		f->q[0] = 0;
+		f->q[1] = Q30_ONE;
+		f->q[2] = 0;
+		f->q[3] = 0;
+	}
+
+	f->have_q = true;
+}
+
+void fusion_init(struct fusion *f, const struct fusion_config *cfg)
+{
+	memset(f, 0, sizeof(*f));
+	f->cfg = *cfg;
+	f->q[0] = Q30_ONE;
+}
+
+static void fusion_update(struct fusion *f, const q31_t *gyro, int8_t gy_shift)
+{
+	int32_t *q = f->q;
+	int32_t u[3], v[3], h[3], dq[4];
+	int64_t accel[3] = { f->accel[0], f->accel[1], f->accel[2] };
+	bool correct = f->have_accel && fusion_normalize(accel, u, 3);
+	int shift = 33 - gy_shift;
+	int64_t n2;
+	int32_t k;
+
+	/* half the rotation angle during dt, rad in q30 */
+	for (int i = 0; i < 3; i++) {
+		int64_t a = (int64_t)gyro[i] * f->dt_q31;
+
+		h[i] = (int32_t)((shift >= 0) ? (a >> shift) : (a << -shift));
+	}
+
+	fusion_gravity(q, v);
+
+	if (correct && f->cfg.algo == FUSION_MAHONY) {
+		/* the error is the rotation from the predicted to the measured gravity */
+		int32_t e[3] = {
+			mul30(u[1], v[2]) - mul30(u[2], v[1]),
+			mul30(u[2], v[0]) - mul30(u[0], v[2]),
+			mul30(u[0], v[1]) - mul30(u[1], v[0]),
+		};
+
+		for (int i = 0; i < 3; i++) {
+			int32_t rate = ((int64_t)f->cfg.gain_q16 * e[i]) >> 16;
+
+			if (f->cfg.ki_q16 != 0) {
+				int32_t ki_e = ((int64_t)f->cfg.ki_q16 * e[i]) >> 16;
+
+				f->integral[i] += ((int64_t)ki_e * f->dt_q31) >> 31;
+			}
+
+			rate += f->integral[i];
+			h[i] += ((int64_t)rate * f->dt_q31) >> 32;
+		}
+	}
+
+	/* dq = q * (0, h) */
+	dq[0] = -(mul30(q[1], h[0]) + mul30(q[2], h[1]) + mul30(q[3], h[2]));
+	dq[1] = mul30(q[0], h[0]) + mul30(q[2], h[2]) - mul30(q[3], h[1]);
+	dq[2] = mul30(q[0], h[1]) - mul30(q[1], h[2]) + mul30(q[3], h[0]);
+	dq[3] = mul30(q[0], h[2]) + mul30(q[1], h[1]) - mul30(q[2], h[0]);
+
+	if (correct && f->cfg.algo == FUSION_MADGWICK) {
+		/* gradient of |v(q) - u|^2 */
+		int32_t e[3] = { v[0] - u[0], v[1] - u[1], v[2] - u[2] };
+		int64_t grad[4] = {
+			2LL * (-mul30(q[2], e[0]) + mul30(q[1], e[1])),
+			2LL * (mul30(q[3], e[0]) + mul30(q[0], e[1])) - 4LL * mul30(q[1], e[2]),
+			2LL * (-mul30(q[0], e[0]) + mul30(q[3], e[1])) - 4LL * mul30(q[2], e[2]),
+			2LL * (mul30(q[1], e[0]) + mul30(q[2], e[1])),
+		};
+		int32_t s[4];
+
+		if (fusion_normalize(grad, s, 4)) {
+			/* beta * dt in q31 */
+			int32_t step = ((int64_t)f->cfg.gain_q16 * f->dt_q31) >> 16;
+
+			for (int i = 0; i < 4; i++) {
+				dq[i] -= ((int64_t)s[i] * step) >> 31;
+			}
+		}
+	}
+
+	for (int i = 0; i < 4; i++) {
+		q[i] += dq[i];
+	}
+
+	/* q stays close to unit length, one Newton step of 1 / sqrt(|q|^2) is enough */
+	n2 = 0;
+	for (int i = 0; i < 4; i++) {
+		n2 += (int64_t)q[i] * q[i];
+	}
+	k = (int32_t)(((3LL << 60) - n2) >> 31);
+	for (int i = 0; i < 4; i++) {
+		q[i] = mul30(q[i], k);
+	}
+}
+
+uint16_t fusion_process(struct fusion *f, const struct imu_sample *xl, uint16_t n_xl,
+			const struct imu_sample *gy, uint16_t n_gy, int8_t gy_shift,
+			struct imu_sample *quat, struct imu_sample *gravity, uint16_t out_max)
+{
+	uint16_t j = 0, n = 0;
+
+	for (uint16_t k = 0; k < n_gy; k++) {
+		uint64_t ts = gy[k].timestamp_ns;
+
+		while (j < n_xl && xl[j].timestamp_ns <= ts) {
+			memcpy(f->accel, xl[j].v, sizeof(f->accel));
+			f->have_accel = true;
+			j++;
+		}
+
+		if (!f->have_q) {
+			int64_t a[3] = { f->accel[0], f->accel[1], f->accel[2] };
+			int32_t u[3];
+
+			if (!f->have_accel || !fusion_normalize(a, u, 3)) {
+				continue;
+			}
+			fusion_init_from_accel(f, u);
+		} else if (ts > f->last_ns && ts - f->last_ns < NSEC_PER_SEC) {
+			uint32_t dt_ns = ts - f->last_ns;
+
+			if (dt_ns != f->dt_ns) {
+				f->dt_ns = dt_ns;
+				f->dt_q31 = (int32_t)(((uint64_t)dt_ns << 31) / NSEC_PER_SEC);
+			}
+
+			fusion_update(f, gy[k].v, gy_shift);
+		}
+
+		f->last_ns = ts;
+
+		if (n >= out_max) {
+			continue;
+		}
+
+		quat[n].timestamp_ns = ts;
+		quat[n].v[0] = f->q[1];
+		quat[n].v[1] = f->q[2];
+		quat[n].v[2] = f->q[3];
+		quat[n].v[3] = f->q[0];
+
+		if (gravity != NULL) {
+			int32_t v[3];
+
+			fusion_gravity(f->q, v);
+			gravity[n].timestamp_ns = ts;
+			for (int i = 0; i < 3; i++) {
+				gravity[n].v[i] = (q31_t)(((int64_t)v[i] * FUSION_G_Q20) >> 20);
+			}
+			gravity[n].v[3] = 0;
+		}
+
+		n++;
+	}
+
+	/* accelerometer frames newer than the last gyroscope frame */
+	if (j < n_xl) {
+		memcpy(f->accel, xl[n_xl - 1].v, sizeof(f->accel));
+		f->have_accel = true;
+	}
+
+	return n;
+}
+
+/* Index of the frame of @p s closest in time to @p ts, searching forward from @p from */
+static uint16_t fusion_nearest(const struct imu_sample *s, uint16_t n, uint64_t ts, uint16_t from)
+{
+	while (from + 1 < n &&
+	       llabs((int64_t)(s[from + 1].timestamp_ns - ts)) <=
+	       llabs((int64_t)(s[from].timestamp_ns - ts))) {
+		from++;
+	}
+
+	return from;
+}
+
+static float fusion_deg(float rad)
+{
+	return rad * (180.0f / (float)M_PI);
+}
+
+/* (w, x, y, z) of a quaternion frame stored as x, y, z, w */
+static void fusion_quat_float(const struct imu_sample *s, int8_t shift, float *q)
+{
+	float scale = ldexpf(1.0f, shift - 31);
+
+	q[0] = s->v[3] * scale;
+	q[1] = s->v[0] * scale;
+	q[2] = s->v[1] * scale;
+	q[3] = s->v[2] * scale;
+}
+
+/* a * conj(b) */
+static void fusion_quat_mul_conj(const float *a, const float *b, float *out)
+{
+	out[0] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	out[1] = -a[0] * b[1] + a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+	out[2] = -a[0] * b[2] + a[1] * b[3] + a[2] * b[0] - a[3] * b[1];
+	out[3] = -a[0] * b[3] - a[1] * b[2] + a[2] * b[1] + a[3] * b[0];
+}
+
+void fusion_accuracy_add(struct fusion_accuracy *acc, const struct imu_sample *quat,
+			 const struct imu_sample *gravity, uint16_t n,
+			 const struct imu_sample *ref_rot, uint16_t n_rot, int8_t rot_shift,
+			 const struct imu_sample *ref_gravity, uint16_t n_gravity)
+{
+	uint16_t k = 0;
+
+	if (n == 0) {
+		return;
+	}
+
+	for (uint16_t i = 0; i < n_rot; i++) {
+		float qf[4], qr[4], d[4], e[4], err;
+
+		if (ref_rot[i].timestamp_ns < quat[0].timestamp_ns ||
+		    ref_rot[i].timestamp_ns > quat[n - 1].timestamp_ns) {
+			continue;
+		}
+
+		k = fusion_nearest(quat, n, ref_rot[i].timestamp_ns, k);
+		fusion_quat_float(&quat[k], FUSION_Q_SHIFT, qf);
+		fusion_quat_float(&ref_rot[i], rot_shift, qr);
+
+		/* both are game rotations, only changes of their heading offset are errors */
+		fusion_quat_mul_conj(qf, qr, d);
+		if (!acc->have_heading) {
+			memcpy(acc->heading, d, sizeof(d));
+			acc->have_heading = true;
+		}
+		fusion_quat_mul_conj(d, acc->heading, e);
+
+		err = fusion_deg(2.0f * acosf(MIN(fabsf(e[0]), 1.0f)));
+		acc->rot_sum += err;
+		acc->rot_max = MAX(acc->rot_max, err);
+		acc->rot_count++;
+	}
+
+	k = 0;
+	for (uint16_t i = 0; gravity != NULL && i < n_gravity; i++) {
+		const q31_t *a, *b;
+		float cross[3], dot, err;
+
+		if (ref_gravity[i].timestamp_ns < gravity[0].timestamp_ns ||
+		    ref_gravity[i].timestamp_ns > gravity[n - 1].timestamp_ns) {
+			continue;
+		}
+
+		k = fusion_nearest(gravity, n, ref_gravity[i].timestamp_ns, k);
+		a = gravity[k].v;
+		b = ref_gravity[i].v;
+
+		/* the angle between the directions does not depend on the scales */
+		cross[0] = (float)a[1] * b[2] - (float)a[2] * b[1];
+		cross[1] = (float)a[2] * b[0] - (float)a[0] * b[2];
+		cross[2] = (float)a[0] * b[1] - (float)a[1] * b[0];
+		dot = (float)a[0] * b[0] + (float)a[1] * b[1] + (float)a[2] * b[2];
+
+		err = fusion_deg(atan2f(sqrtf(cross[0] * cross[0] + cross[1] * cross[1] +
+					      cross[2] * cross[2]), dot));
+		acc->tilt_sum += err;
+		acc->tilt_max = MAX(acc->tilt_max, err);
+		acc->tilt_count++;
+	}
+}
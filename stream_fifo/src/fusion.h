@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FUSION_H_
+#define FUSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+/* Quaternions and unit vectors are q30, i.e. q31 values with a shift of 1 */
+#define FUSION_Q_SHIFT		1
+/* Gravity output in m/s^2, q31 with a shift of 5 */
+#define FUSION_GRAVITY_SHIFT	5
+
+enum fusion_algo {
+	/* complementary filter with proportional-integral feedback */
+	FUSION_MAHONY,
+	/* gradient descent step towards the accelerometer */
+	FUSION_MADGWICK,
+};
+
+struct fusion_config {
+	enum fusion_algo algo;
+	/* Mahony proportional gain or Madgwick beta, in 1/s as Q16.16 */
+	uint32_t gain_q16;
+	/* Mahony integral gain in 1/s^2 as Q16.16, 0 disables gyro bias tracking */
+	uint32_t ki_q16;
+};
+
+/*
+ * 6-axis orientation filter state. The quaternion rotates sensor frame
+ * vectors into a gravity aligned frame whose heading is arbitrary, like a
+ * game rotation vector.
+ */
+struct fusion {
+	struct fusion_config cfg;
+	/* w, x, y, z */
+	int32_t q[4];
+	/* Mahony integral term, rad/s in q30 */
+	int32_t integral[3];
+	/* latest accelerometer frame, any common shift */
+	q31_t accel[3];
+	bool have_accel;
+	bool have_q;
+	uint64_t last_ns;
+	/* cached conversion of the last sample period to seconds in q31 */
+	uint32_t dt_ns;
+	int32_t dt_q31;
+};
+
+void fusion_init(struct fusion *f, const struct fusion_config *cfg);
+
+/**
+ * @brief Run the filter over the frames of one FIFO drain.
+ *
+ * Frames of both channels are consumed in timestamp order: every gyroscope
+ * frame advances the orientation, using the latest accelerometer frame not
+ * newer than it for the correction. The state is kept across calls.
+ *
+ * @param xl Accelerometer frames in time order
+ * @param gy Gyroscope frames in time order, in rad/s
+ * @param gy_shift Decoder shift of the gyroscope frames
+ * @param quat Output quaternion per gyroscope frame, v[] = x, y, z, w (FUSION_Q_SHIFT)
+ * @param gravity Output gravity vector per gyroscope frame (FUSION_GRAVITY_SHIFT),
+ *		  may be NULL
+ * @param out_max Capacity of @p quat and @p gravity
+ * @return Number of output frames written
+ */
+uint16_t fusion_process(struct fusion *f, const struct imu_sample *xl, uint16_t n_xl,
+			const struct imu_sample *gy, uint16_t n_gy, int8_t gy_shift,
+			struct imu_sample *quat, struct imu_sample *gravity, uint16_t out_max);
+
+/* Orientation error against the sensor fusion outputs of the device */
+struct fusion_accuracy {
+	uint32_t rot_count;
+	uint32_t tilt_count;
+	/* degrees */
+	float rot_sum;
+	float rot_max;
+	float tilt_sum;
+	float tilt_max;
+	/* heading offset between the two game rotations at the first comparison */
+	float heading[4];
+	bool have_heading;
+};
+
+/**
+ * @brief Compare fusion outputs with reference frames of the same drain.
+ *
+ * Each reference frame is matched with the output frame closest in time.
+ * The rotation error is the angle of the relative rotation, once the
+ * initial heading offset between the two is removed. The tilt error is
+ * the angle between the gravity directions.
+ *
+ * @param quat, gravity, n Output of fusion_process()
+ * @param ref_rot Game rotation vector frames, v[] = x, y, z, w
+ * @param rot_shift Decoder shift of @p ref_rot
+ * @param ref_gravity Gravity vector frames, any common shift
+ */
+void fusion_accuracy_add(struct fusion_accuracy *acc, const struct imu_sample *quat,
+			 const struct imu_sample *gravity, uint16_t n,
+			 const struct imu_sample *ref_rot, uint16_t n_rot, int8_t rot_shift,
+			 const struct imu_sample *ref_gravity, uint16_t n_gravity);
+
+#endif /* FUSION_H_ */
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/sys/time_units.h>
+#include <zephyr/sys/util.h>
+
+#include "history.h"
+
+BUILD_ASSERT(HISTORY_TIER_BUCKETS > CONFIG_STREAM_FIFO_HISTORY_FACTOR,
+	     "a tier must hold the buckets not merged into the next one yet");
+
+/* Running totals of a query */
+struct history_acc {
+	uint32_t count;
+	q31_t min[HISTORY_MAX_VALUES];
+	q31_t max[HISTORY_MAX_VALUES];
+	int64_t sum[HISTORY_MAX_VALUES];
+	uint64_t start_ns;
+	uint64_t end_ns;
+	uint32_t visited;
+};
+
+static inline uint64_t round_down(uint64_t x, uint64_t p)
+{
+	return x - (x % p);
+}
+
+static inline uint64_t round_up(uint64_t x, uint64_t p)
+{
+	return round_down(x + p - 1, p);
+}
+
+/* v * 2^(from - to), saturated */
+static q31_t history_rescale(q31_t v, int8_t from, int8_t to)
+{
+	int64_t r = (from >= to) ? ((int64_t)v << MIN(from - to, 32)) : (v >> MIN(to - from, 31));
+
+	return (q31_t)CLAMP(r, INT32_MIN, INT32_MAX);
+}
+
+void history_init(struct history *h, uint8_t values, uint32_t bucket_ms, uint8_t factor)
+{
+	uint64_t period_ns = (uint64_t)bucket_ms * NSEC_PER_MSEC;
+
+	memset(h, 0, sizeof(*h));
+	h->values = MIN(values, HISTORY_MAX_VALUES);
+
+	for (int t = 0; t < HISTORY_TIERS; t++) {
+		h->tiers[t].period_ns = period_ns;
+		period_ns *= factor;
+	}
+}
+
+static void history_bucket_add(struct history_bucket *b, uint64_t start_ns, const q31_t *v,
+			       uint8_t values)
+{
+	if (b->count == 0) {
+		b->start_ns = start_ns;
+		for (int i = 0; i < values; i++) {
+			b->min[i] = v[i];
+			b->max[i] = v[i];
+			b->sum[i] = 0;
+		}
+	}
+
+	for (int i = 0; i < values; i++) {
+		b->min[i] = MIN(b->min[i], v[i]);
+		b->max[i] = MAX(b->max[i], v[i]);
+		b->sum[i] += v[i];
+	}
+	b->count++;
+}
+
+static void history_bucket_merge(struct history_bucket *dst, uint64_t start_ns,
+				 const struct history_bucket *src, uint8_t values)
+{
+	if (dst->count == 0) {
+		*dst = *src;
+		dst->start_ns = start_ns;
+		return;
+	}
+
+	for (int i = 0; i < values; i++) {
+		dst->min[i] = MIN(dst->min[i], src->min[i]);
+		dst->max[i] = MAX(dst->max[i], src->max[i]);
+		dst->sum[i] += src->sum[i];
+	}
+	dst->count += src->count;
+}
+
+static void history_tier_push(struct history_tier *tier, const struct history_bucket *b)
+{
+	if (tier->count == HISTORY_TIER_BUCKETS) {
+		tier->complete_ns = tier->buckets[tier->head].start_ns + tier->period_ns;
+		tier->head = (tier->head + 1) % HISTORY_TIER_BUCKETS;
+		tier->count--;
+	}
+
+	tier->buckets[(tier->head + tier->count) % HISTORY_TIER_BUCKETS] = *b;
+	tier->count++;
+}
+
+/* Close the open buckets that end before @p ts, cascading to the coarser tiers */
+static void history_close(struct history *h, uint64_t ts)
+{
+	for (int t = 0; t < HISTORY_TIERS; t++) {
+		struct history_tier *tier = &h->tiers[t];
+		struct history_bucket closed = tier->open;
+
+		/* boundaries of a tier are boundaries of the tiers below */
+		if (closed.count == 0 || closed.start_ns == round_down(ts, tier->period_ns)) {
+			break;
+		}
+
+		tier->open.count = 0;
+		history_tier_push(tier, &closed);
+
+		if (t + 1 < HISTORY_TIERS) {
+			struct history_tier *next = &h->tiers[t + 1];
+
+			history_bucket_merge(&next->open, round_down(closed.start_ns, next->period_ns),
+					     &closed, h->values);
+		}
+	}
+}
+
+void history_add(struct history *h, const struct imu_sample *s, uint16_t n, int8_t shift)
+{
+	if (!h->have_shift) {
+		h->shift = shift;
+		h->have_shift = true;
+	}
+
+	for (uint16_t k = 0; k < n; k++) {
+		uint64_t ts = s[k].timestamp_ns;
+		struct imu_sample *raw;
+
+		if (h->raw_count > 0 && ts < h->last_ns) {
+			h->out_of_order++;
+			continue;
+		}
+
+		if (h->raw_count == HISTORY_RAW_SAMPLES) {
+			h->raw_complete_ns = h->raw[h->raw_head].timestamp_ns + 1;
+			h->raw_head = (h->raw_head + 1) % HISTORY_RAW_SAMPLES;
+			h->raw_count--;
+		}
+
+		raw = &h->raw[(h->raw_head + h->raw_count) % HISTORY_RAW_SAMPLES];
+		raw->timestamp_ns = ts;
+		for (int i = 0; i < h->values; i++) {
+			raw->v[i] = (shift == h->shift) ? s[k].v[i]
+							: history_rescale(s[k].v[i], shift, h->shift);
+		}
+		h->raw_count++;
+
+		history_close(h, ts);
+		history_bucket_add(&h->tiers[0].open, round_down(ts, h->tiers[0].period_ns), raw->v,
+				   h->values);
+		h->last_ns = ts;
+	}
+}
+
+/* Index of the first raw frame at or after @p ts, in ring order */
+static uint16_t history_raw_search(const struct history *h, uint64_t ts)
+{
+	uint16_t lo = 0, hi = h->raw_count;
+
+	while (lo < hi) {
+		uint16_t mid = lo + (hi - lo) / 2;
+
+		if (h->raw[(h->raw_head + mid) % HISTORY_RAW_SAMPLES].timestamp_ns < ts) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/* Index of the first bucket starting at or after @p ts, in ring order */
+static uint16_t history_tier_search(const struct history_tier *tier, uint64_t ts)
+{
+	uint16_t lo = 0, hi = tier->count;
+
+	while (lo < hi) {
+		uint16_t mid = lo + (hi - lo) / 2;
+
+		if (tier->buckets[(tier->head + mid) % HISTORY_TIER_BUCKETS].start_ns < ts) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static void history_acc_add(struct history_acc *acc, const struct history_bucket *b,
+			    uint64_t end_ns, uint8_t values)
+{
+	if (acc->count == 0) {
+		acc->start_ns = b->start_ns;
+		for (int i = 0; i < values; i++) {
+			acc->min[i] = b->min[i];
+			acc->max[i] = b->max[i];
+		}
+	}
+
+	for (int i = 0; i < values; i++) {
+		acc->min[i] = MIN(acc->min[i], b->min[i]);
+		acc->max[i] = MAX(acc->max[i], b->max[i]);
+		acc->sum[i] += b->sum[i];
+	}
+	acc->count += b->count;
+	acc->start_ns = MIN(acc->start_ns, b->start_ns);
+	acc->end_ns = MAX(acc->end_ns, end_ns);
+	acc->visited++;
+}
+
+/* Add the frames (level 0) or the buckets of tier level - 1 starting in [a, b) */
+static void history_take(const struct history *h, int level, uint64_t a, uint64_t b,
+			 struct history_acc *acc)
+{
+	if (level == 0) {
+		for (uint16_t k = history_raw_search(h, a); k < h->raw_count; k++) {
+			const struct imu_sample *s = &h->raw[(h->raw_head + k) % HISTORY_RAW_SAMPLES];
+			struct history_bucket one = { .start_ns = s->timestamp_ns, .count = 1 };
+
+			if (s->timestamp_ns >= b) {
+				break;
+			}
+
+			for (int i = 0; i < h->values; i++) {
+				one.min[i] = s->v[i];
+				one.max[i] = s->v[i];
+				one.sum[i] = s->v[i];
+			}
+			history_acc_add(acc, &one, s->timestamp_ns + 1, h->values);
+		}
+		return;
+	}
+
+	const struct history_tier *tier = &h->tiers[level - 1];
+
+	for (uint16_t k = history_tier_search(tier, a); k < tier->count; k++) {
+		const struct history_bucket *bk =
+			&tier->buckets[(tier->head + k) % HISTORY_TIER_BUCKETS];
+
+		if (bk->start_ns >= b) {
+			break;
+		}
+
+		history_acc_add(acc, bk, bk->start_ns + tier->period_ns, h->values);
+	}
+}
+
+int history_query(const struct history *h, uint64_t from_ns, uint64_t to_ns,
+		  struct history_result *r)
+{
+	struct history_acc acc = { 0 };
+	uint64_t lo = from_ns;
+	uint64_t hi = (h->raw_count > 0) ? MIN(to_ns, h->last_ns + 1) : 0;
+
+	for (int level = 0; level <= HISTORY_TIERS && lo < hi; level++) {
+		uint64_t complete = (level == 0) ? h->raw_complete_ns
+						 : h->tiers[level - 1].complete_ns;
+		uint64_t p, a, b, left_end, right_start, next_lo, next_hi;
+
+		if (level == HISTORY_TIERS) {
+			/* coarsest tier, whatever expired is lost */
+			history_take(h, level, lo, hi, &acc);
+			break;
+		}
+
+		/* [a, b) is made of whole buckets of the next level */
+		p = h->tiers[level].period_ns;
+		a = round_up(lo, p);
+		b = round_down(hi, p);
+		left_end = MIN(a, hi);
+		right_start = MAX(b, left_end);
+		next_lo = a;
+		next_hi = b;
+
+		if (lo < left_end) {
+			if (lo >= complete) {
+				history_take(h, level, lo, left_end, &acc);
+			} else {
+				/* this end expired here, use the whole bucket of the next level */
+				next_lo = round_down(lo, p);
+				next_hi = MAX(next_hi, next_lo + p);
+			}
+		}
+
+		if (right_start < hi) {
+			if (right_start >= complete) {
+				history_take(h, level, right_start, hi, &acc);
+			} else {
+				next_hi = round_up(hi, p);
+				next_lo = MIN(next_lo, next_hi - p);
+			}
+		}
+
+		lo = next_lo;
+		hi = next_hi;
+	}
+
+	if (acc.count == 0) {
+		return -ENODATA;
+	}
+
+	r->start_ns = acc.start_ns;
+	r->end_ns = acc.end_ns;
+	r->count = acc.count;
+	r->shift = h->shift;
+	r->visited = acc.visited;
+	for (int i = 0; i < h->values; i++) {
+		r->min[i] = acc.min[i];
+		r->max[i] = acc.max[i];
+		r->mean[i] = (q31_t)(acc.sum[i] / (int64_t)acc.count);
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+#define HISTORY_MAX_VALUES	3
+#define HISTORY_RAW_SAMPLES	CONFIG_STREAM_FIFO_HISTORY_RAW_SAMPLES
+#define HISTORY_TIERS		CONFIG_STREAM_FIFO_HISTORY_TIERS
+#define HISTORY_TIER_BUCKETS	CONFIG_STREAM_FIFO_HISTORY_TIER_BUCKETS
+
+/* Aggregate of the frames whose timestamp falls in [start_ns, start_ns + period) */
+struct history_bucket {
+	uint64_t start_ns;
+	uint32_t count;
+	q31_t min[HISTORY_MAX_VALUES];
+	q31_t max[HISTORY_MAX_VALUES];
+	int64_t sum[HISTORY_MAX_VALUES];
+};
+
+/* Ring of closed buckets of one period, oldest first */
+struct history_tier {
+	struct history_bucket buckets[HISTORY_TIER_BUCKETS];
+	uint16_t head;
+	uint16_t count;
+	uint64_t period_ns;
+	/* bucket still receiving frames, or buckets of the tier below */
+	struct history_bucket open;
+	/* every bucket starting at or after this time is still stored */
+	uint64_t complete_ns;
+};
+
+/*
+ * History of one channel in fixed RAM: the latest frames at full rate,
+ * then tiers of min/max/sum buckets whose period grows by a constant
+ * factor. Bucket boundaries are multiples of the period, so a bucket of
+ * a tier is exactly the union of factor buckets of the tier below.
+ *
+ * Not thread safe: history_add() and history_query() must be serialized
+ * by the caller.
+ */
+struct history {
+	struct imu_sample raw[HISTORY_RAW_SAMPLES];
+	uint16_t raw_head;
+	uint16_t raw_count;
+	/* every frame at or after this time is still in raw[] */
+	uint64_t raw_complete_ns;
+	struct history_tier tiers[HISTORY_TIERS];
+	uint8_t values;
+	/* q31 format of the stored values, set by the first frame */
+	int8_t shift;
+	bool have_shift;
+	uint64_t last_ns;
+	/* frames older than the latest one, not stored */
+	uint32_t out_of_order;
+};
+
+struct history_result {
+	/* time actually covered, wider than requested where the fine tiers expired */
+	uint64_t start_ns;
+	uint64_t end_ns;
+	uint32_t count;
+	q31_t min[HISTORY_MAX_VALUES];
+	q31_t max[HISTORY_MAX_VALUES];
+	q31_t mean[HISTORY_MAX_VALUES];
+	int8_t shift;
+	/* frames and buckets read to answer */
+	uint32_t visited;
+};
+
+/**
+ * @brief Reset a history.
+ *
+ * @param values Number of v[] values tracked per frame, up to HISTORY_MAX_VALUES
+ * @param bucket_ms Period of the finest tier
+ * @param factor Period ratio between a tier and the one below
+ */
+void history_init(struct history *h, uint8_t values, uint32_t bucket_ms, uint8_t factor);
+
+/**
+ * @brief Store frames in time order.
+ *
+ * Every frame is copied to the full-rate ring and added to the open bucket
+ * of the finest tier. A bucket is closed by the first frame past its end,
+ * and merged into the open bucket of the next tier, so the cost per frame
+ * is constant apart from the bucket closes.
+ *
+ * @param shift Decoder shift of the frames, converted to the one of the first frame
+ */
+void history_add(struct history *h, const struct imu_sample *s, uint16_t n, int8_t shift);
+
+/**
+ * @brief Aggregate the frames of [from_ns, to_ns).
+ *
+ * The range is split at the bucket boundaries: the ragged ends come from
+ * the full-rate ring and the fine tiers, the middle from the coarsest
+ * tier. Each level reads at most 2 * factor buckets after a binary search,
+ * so the cost grows with log(range) and not with the number of frames.
+ * Where a fine tier no longer holds an end of the range, the whole bucket
+ * of the next tier is used and the result covers a wider span.
+ *
+ * @return 0 on success, -ENODATA if no stored frame is in the range
+ */
+int history_query(const struct history *h, uint64_t from_ns, uint64_t to_ns,
+		  struct history_result *r);
+
+/* Size of the history and cost of history_add() and history_query() */
+void history_bench(void);
+
+#endif /* HISTORY_H_ */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "history.h"
+
+#define BENCH_HZ	CONFIG_STREAM_FIFO_HISTORY_BENCH_HZ
+#define BENCH_FRAMES	64
+#define BENCH_QUERIES	32
+
+static struct history bench_history;
+
+/* Query spans, from a few frames to past the coarsest tier */
+static const uint32_t bench_spans_ms[] = { 100, 1000, 10000, 60000, 600000, 3600000 };
+
+static void bench_fill(struct imu_sample *s, uint32_t first)
+{
+	for (uint16_t k = 0; k < BENCH_FRAMES; k++) {
+		uint32_t n = first + k;
+
+		s[k].timestamp_ns = (uint64_t)n * NSEC_PER_SEC / BENCH_HZ;
+		s[k].v[0] = (int32_t)(n * 0x9e3779b9U) >> 8;
+		s[k].v[1] = (int32_t)(n % BENCH_HZ) << 16;
+		s[k].v[2] = BIT(28);
+	}
+}
+
+void history_bench(void)
+{
+	static struct imu_sample frames[BENCH_FRAMES];
+	uint32_t total = CONFIG_STREAM_FIFO_HISTORY_BENCH_SECONDS * BENCH_HZ;
+	uint64_t add_cycles = 0, horizon_ms;
+	uint64_t now_ns;
+
+	history_init(&bench_history, 3, CONFIG_STREAM_FIFO_HISTORY_BUCKET_MS,
+		     CONFIG_STREAM_FIFO_HISTORY_FACTOR);
+
+	horizon_ms = (uint64_t)HISTORY_RAW_SAMPLES * MSEC_PER_SEC / BENCH_HZ;
+	printk("history bench: %zu bytes per channel, raw %u frames (%llu ms at %u Hz)",
+	       sizeof(bench_history), HISTORY_RAW_SAMPLES, horizon_ms, BENCH_HZ);
+	for (int t = 0; t < HISTORY_TIERS; t++) {
+		printk(", %u x %llu ms", HISTORY_TIER_BUCKETS,
+		       bench_history.tiers[t].period_ns / NSEC_PER_MSEC);
+	}
+	printk("\n");
+
+	for (uint32_t n = 0; n < total; n += BENCH_FRAMES) {
+		uint32_t start;
+
+		bench_fill(frames, n);
+		start = k_cycle_get_32();
+		history_add(&bench_history, frames, BENCH_FRAMES, 0);
+		add_cycles += k_cycle_get_32() - start;
+	}
+
+	printk("history bench: %u s at %u Hz stored, %llu cycles/frame\n",
+	       CONFIG_STREAM_FIFO_HISTORY_BENCH_SECONDS, BENCH_HZ,
+	       add_cycles / ROUND_UP(total, BENCH_FRAMES));
+
+	now_ns = bench_history.last_ns + 1;
+
+	for (int i = 0; i < ARRAY_SIZE(bench_spans_ms); i++) {
+		uint64_t span_ns = (uint64_t)bench_spans_ms[i] * NSEC_PER_MSEC;
+		uint64_t cycles = 0, covered_ns = 0;
+		uint32_t visited = 0, count = 0;
+
+		for (int q = 0; q < BENCH_QUERIES; q++) {
+			/* the end moves back in uneven steps, to hit every bucket alignment */
+			uint64_t to = now_ns - (uint64_t)q * 7919 * NSEC_PER_USEC;
+			struct history_result r;
+			uint32_t start = k_cycle_get_32();
+			int rc = history_query(&bench_history, (to > span_ns) ? (to - span_ns) : 0,
+					       to, &r);
+
+			cycles += k_cycle_get_32() - start;
+			if (rc == 0) {
+				visited += r.visited;
+				count += r.count;
+				covered_ns += r.end_ns - r.start_ns;
+			}
+		}
+
+		printk("history bench: last %u ms: %llu cycles/query, %u entries read, "
+		       "%u frames, %llu ms covered\n", bench_spans_ms[i],
+		       cycles / BENCH_QUERIES, visited / BENCH_QUERIES, count / BENCH_QUERIES,
+		       covered_ns / BENCH_QUERIES / NSEC_PER_MSEC);
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+
+#include "imu_batch.h"
+
+const char *const imu_chan_name[IMU_CHAN_COUNT] = {
+	[IMU_CHAN_XL] = "XL", [IMU_CHAN_GY] = "GY", [IMU_CHAN_TEMP] = "TP",
+	[IMU_CHAN_ROT] = "ROT", [IMU_CHAN_GRAVITY] = "GV", [IMU_CHAN_GBIAS] = "GY GBIAS",
+};
+
+const uint8_t imu_chan_values[IMU_CHAN_COUNT] = {
+	[IMU_CHAN_XL] = 3, [IMU_CHAN_GY] = 3, [IMU_CHAN_TEMP] = 1,
+	[IMU_CHAN_ROT] = 4, [IMU_CHAN_GRAVITY] = 3, [IMU_CHAN_GBIAS] = 3,
+};
+
+void imu_batch_reset(struct imu_batch *batch, uint8_t sensor, uint64_t arrival_ns,
+		     const uint16_t counts[IMU_CHAN_COUNT])
+{
+	uint16_t offset = 0;
+
+	batch->sensor = sensor;
+	batch->arrival_ns = arrival_ns;
+	batch->dropped = 0;
+#ifdef CONFIG_STREAM_FIFO_SHED
+	batch->decim = 1;
+#endif
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		uint16_t size = MIN(counts[i], ARRAY_SIZE(batch->samples) - offset);
+
+		batch->chan[i].offset = offset;
+		batch->chan[i].size = size;
+		batch->chan[i].count = 0;
+		batch->chan[i].shift = 0;
+		batch->dropped += counts[i] - size;
+		offset += size;
+	}
+}
+
+static struct imu_sample *imu_batch_next(struct imu_batch *batch, enum imu_chan chan)
+{
+	struct imu_batch_chan *c = &batch->chan[chan];
+
+	if (c->count >= c->size) {
+		return NULL;
+	}
+
+	return &batch->samples[c->offset + c->count++];
+}
+
+void imu_batch_add_three_axis(struct imu_batch *batch, enum imu_chan chan,
+			      const struct sensor_three_axis_data *data, int count)
+{
+	batch->chan[chan].shift = data->shift;
+
+	for (int k = 0; k < count; k++) {
+		struct imu_sample *s = imu_batch_next(batch, chan);
+
+		if (s == NULL) {
+			return;
+		}
+
+		s->timestamp_ns = data->header.base_timestamp_ns +
+				  data->readings[k].timestamp_delta;
+		s->v[0] = data->readings[k].x;
+		s->v[1] = data->readings[k].y;
+		s->v[2] = data->readings[k].z;
+		s->v[3] = 0;
+	}
+}
+
+void imu_batch_add_q31(struct imu_batch *batch, enum imu_chan chan,
+		       const struct sensor_q31_data *data, int count)
+{
+	batch->chan[chan].shift = data->shift;
+
+	for (int k = 0; k < count; k++) {
+		struct imu_sample *s = imu_batch_next(batch, chan);
+
+		if (s == NULL) {
+			return;
+		}
+
+		s->timestamp_ns = data->header.base_timestamp_ns +
+				  data->readings[k].timestamp_delta;
+		s->v[0] = data->readings[k].value;
+		s->v[1] = 0;
+		s->v[2] = 0;
+		s->v[3] = 0;
+	}
+}
+
+void imu_batch_add_rotation(struct imu_batch *batch, enum imu_chan chan,
+			    const struct sensor_game_rotation_vector_data *data, int count)
+{
+	batch->chan[chan].shift = data->shift;
+
+	for (int k = 0; k < count; k++) {
+		struct imu_sample *s = imu_batch_next(batch, chan);
+
+		if (s == NULL) {
+			return;
+		}
+
+		s->timestamp_ns = data->header.base_timestamp_ns +
+				  data->readings[k].timestamp_delta;
+		s->v[0] = data->readings[k].x;
+		s->v[1] = data->readings[k].y;
+		s->v[2] = data->readings[k].z;
+		s->v[3] = data->readings[k].w;
+	}
+}
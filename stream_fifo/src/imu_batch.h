@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_BATCH_H_
+#define IMU_BATCH_H_
+
+#include <zephyr/drivers/sensor.h>
+
+#include "imu_sample.h"
+
+/* Channels collected from a FIFO drain */
+enum imu_chan {
+	IMU_CHAN_XL,
+	IMU_CHAN_GY,
+	IMU_CHAN_TEMP,
+	IMU_CHAN_ROT,
+	IMU_CHAN_GRAVITY,
+	IMU_CHAN_GBIAS,
+	IMU_CHAN_COUNT,
+};
+
+/* Short name and number of v[] values of every channel */
+extern const char *const imu_chan_name[IMU_CHAN_COUNT];
+extern const uint8_t imu_chan_values[IMU_CHAN_COUNT];
+
+struct imu_batch_chan {
+	uint16_t offset;
+	/* frames reserved for the channel and frames actually stored */
+	uint16_t size;
+	uint16_t count;
+	int8_t shift;
+};
+
+/* All frames decoded from one FIFO drain, grouped per channel in time order */
+struct imu_batch {
+	uint8_t sensor;
+	/* system uptime when the drain was dequeued */
+	uint64_t arrival_ns;
+	/* frames that did not fit in samples[] */
+	uint16_t dropped;
+#ifdef CONFIG_STREAM_FIFO_SHED
+	/* keep one frame out of decim, the first at phase 0 of every channel */
+	uint8_t decim;
+	uint8_t phase[IMU_CHAN_COUNT];
+#endif
+	struct imu_batch_chan chan[IMU_CHAN_COUNT];
+	struct imu_sample samples[CONFIG_STREAM_FIFO_BATCH_SAMPLES];
+};
+
+static inline struct imu_sample *imu_batch_samples(struct imu_batch *batch, enum imu_chan chan)
+{
+	return &batch->samples[batch->chan[chan].offset];
+}
+
+static inline const struct imu_sample *imu_batch_samples_const(const struct imu_batch *batch,
+								enum imu_chan chan)
+{
+	return &batch->samples[batch->chan[chan].offset];
+}
+
+/**
+ * @brief Start a new batch.
+ *
+ * Reserves a contiguous slice of samples[] for each channel according to
+ * the frame counts reported by the decoder. Channels that do not fit get a
+ * truncated slice and their extra frames are counted as dropped.
+ */
+void imu_batch_reset(struct imu_batch *batch, uint8_t sensor, uint64_t arrival_ns,
+		     const uint16_t counts[IMU_CHAN_COUNT]);
+
+/* Append decoder output to the slice of @p chan */
+void imu_batch_add_three_axis(struct imu_batch *batch, enum imu_chan chan,
+			      const struct sensor_three_axis_data *data, int count);
+void imu_batch_add_q31(struct imu_batch *batch, enum imu_chan chan,
+		       const struct sensor_q31_data *data, int count);
+void imu_batch_add_rotation(struct imu_batch *batch, enum imu_chan chan,
+			    const struct sensor_game_rotation_vector_data *data, int count);
+
+#endif /* IMU_BATCH_H_ */
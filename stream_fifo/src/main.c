@@ -14,10 +14,63 @@
 #include <zephyr/rtio/rtio.h>
 #include <zephyr/drivers/sensor.h>
 
+#include "imu_batch.h"
+#include "mempool_stats.h"
+
+#ifdef CONFIG_STREAM_FIFO_CLOCK_ALIGN
+#include "clock_align.h"
+#include "timeline.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_RESAMPLER
+#include "resample.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_RESAMPLE_BENCH
+#include "resample_bench.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_OUTPUT_SUMMARY
+#include "summary.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SCHEDULER
+#include "sched.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_FUSION
+#include "fusion.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_HISTORY_STORE
+#include "history.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_BUS_PROF
+#include "bus_prof.h"
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SHED
+#include "shed.h"
+#endif
+
+#ifdef CONFIG_EMUL_IMU
+#include "emul_imu.h"
+#endif
+
 #define STREAMDEV_ALIAS(i) DT_ALIAS(_CONCAT(stream, i))
 #define STREAMDEV_DEVICE(i, _) \
 	IF_ENABLED(DT_NODE_EXISTS(STREAMDEV_ALIAS(i)), (DEVICE_DT_GET(STREAMDEV_ALIAS(i)),))
-#define NUM_SENSORS 1
+#define NUM_SENSORS CONFIG_STREAM_FIFO_NUM_SENSORS
+
+#ifdef CONFIG_STREAM_FIFO_CPU_STATS_COMPARE
+/* Per-frame output for the first CPU report, then the summary */
+static bool print_frames = true;
+#define PRINT_FRAMES print_frames
+#else
+/* Print every decoded frame from the acquisition loop */
+#define PRINT_FRAMES IS_ENABLED(CONFIG_STREAM_FIFO_OUTPUT_FRAMES)
+#endif
 
 /* support up to 10 sensors */
 static const struct device *const sensors[] = { LISTIFY(10, STREAMDEV_DEVICE, ()) };
@@ -39,8 +92,59 @@ LISTIFY(NUM_SENSORS, STREAM_DEFINE_IODEV, (;));
 
 struct rtio_iodev *iodevs[NUM_SENSORS] = { LISTIFY(NUM_SENSORS, STREAM_IODEV_PTR, (,)) };
 
-RTIO_DEFINE_WITH_MEMPOOL(stream_ctx, NUM_SENSORS, NUM_SENSORS,
-			 NUM_SENSORS * 20, 256, sizeof(void *));
+#define MEMPOOL_BLOCKS (NUM_SENSORS * CONFIG_STREAM_FIFO_MEMPOOL_BLOCKS)
+#define MEMPOOL_BLOCK_SIZE CONFIG_STREAM_FIFO_MEMPOOL_BLOCK_SIZE
+
+/* every completion holds at least one block, size the CQ to never run out */
+RTIO_DEFINE_WITH_MEMPOOL(stream_ctx, NUM_SENSORS, MEMPOOL_BLOCKS,
+			 MEMPOOL_BLOCKS, MEMPOOL_BLOCK_SIZE, sizeof(void *));
+
+/* The pool must be able to hold one full FIFO drain per sensor */
+#define STREAM_WATERMARK(i, _) DT_PROP_OR(STREAMDEV_ALIAS(i), fifo_watermark, 0)
+#define STREAM_DRAIN_BLOCKS(i, _) MEMPOOL_DRAIN_BLOCKS(STREAM_WATERMARK(i, _), MEMPOOL_BLOCK_SIZE)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(MEMPOOL_BLOCK_SIZE), "mempool block size must be a power of two");
+BUILD_ASSERT((LISTIFY(NUM_SENSORS, STREAM_DRAIN_BLOCKS, (+))) <= MEMPOOL_BLOCKS,
+	     "RTIO mempool cannot hold one full FIFO drain per sensor, "
+	     "increase CONFIG_STREAM_FIFO_MEMPOOL_BLOCKS or BLOCK_SIZE");
+
+#ifdef CONFIG_STREAM_FIFO_MEMPOOL_STATS
+#define STREAM_FIFO_MIX(i, _)								\
+	{										\
+		.xl_hz = mempool_lsm6dsv16x_batch_hz(					\
+			DT_PROP_OR(STREAMDEV_ALIAS(i), accel_fifo_batch_rate, 0)),	\
+		.gy_hz = mempool_lsm6dsv16x_batch_hz(					\
+			DT_PROP_OR(STREAMDEV_ALIAS(i), gyro_fifo_batch_rate, 0)),	\
+		.temp_hz = mempool_lsm6dsv16x_temp_hz(					\
+			DT_PROP_OR(STREAMDEV_ALIAS(i), temp_fifo_batch_rate, 0)),	\
+		.sflp_hz = mempool_lsm6dsv16x_sflp_hz(					\
+			DT_PROP_OR(STREAMDEV_ALIAS(i), sflp_odr, 0)),			\
+		.sflp_outputs = POPCOUNT(						\
+			DT_PROP_OR(STREAMDEV_ALIAS(i), sflp_fifo_enable, 0)),		\
+	}
+
+static struct mempool_stats stream_pool_stats;
+
+static void mempool_report_sizing(void)
+{
+	static const uint16_t watermarks[] = { LISTIFY(NUM_SENSORS, STREAM_WATERMARK, (,)) };
+	const struct mempool_fifo_mix mix[] = { LISTIFY(NUM_SENSORS, STREAM_FIFO_MIX, (,)) };
+	uint32_t blocks = 0;
+
+	for (int i = 0; i < NUM_SENSORS; i++) {
+		uint32_t n = mempool_recommend_blocks(watermarks[i], &mix[i],
+					CONFIG_STREAM_FIFO_MEMPOOL_DRAIN_LATENCY_US,
+					MEMPOOL_BLOCK_SIZE);
+
+		printk("%s: watermark %u, recommended %u mempool blocks\n",
+		       sensors[i]->name, watermarks[i], n);
+		blocks += n;
+	}
+
+	printk("mempool: configured %u blocks, recommended %u blocks of %uB\n",
+	       MEMPOOL_BLOCKS, blocks, MEMPOOL_BLOCK_SIZE);
+}
+#endif /* CONFIG_STREAM_FIFO_MEMPOOL_STATS */
 
 struct sensor_chan_spec accel_chan = { SENSOR_CHAN_ACCEL_XYZ, 0 };
 struct sensor_chan_spec gyro_chan = { SENSOR_CHAN_GYRO_XYZ, 0 };
@@ -49,12 +153,594 @@ struct sensor_chan_spec rot_vector_chan = { SENSOR_CHAN_GAME_ROTATION_VECTOR, 0
 struct sensor_chan_spec gravity_chan = { SENSOR_CHAN_GRAVITY_VECTOR, 0 };
 struct sensor_chan_spec gbias_chan = { SENSOR_CHAN_GBIAS_XYZ, 0 };
 
-static uint8_t accel_buf[128] = { 0 };
-static uint8_t gyro_buf[128] = { 0 };
-static uint8_t temp_buf[64] = { 0 };
-static uint8_t rot_vect_buf[128] = { 0 };
-static uint8_t gravity_buf[128] = { 0 };
-static uint8_t gbias_buf[128] = { 0 };
+/* Decoder output holding @p n frames */
+#define DECODE_BUF_SIZE(type, n) (sizeof(type) + ((n) - 1) * sizeof(((type *)0)->readings[0]))
+
+static uint8_t accel_buf[DECODE_BUF_SIZE(struct sensor_three_axis_data, 8)] __aligned(8);
+static uint8_t gyro_buf[DECODE_BUF_SIZE(struct sensor_three_axis_data, 8)] __aligned(8);
+static uint8_t temp_buf[DECODE_BUF_SIZE(struct sensor_q31_data, 4)] __aligned(8);
+static uint8_t rot_vect_buf[DECODE_BUF_SIZE(struct sensor_game_rotation_vector_data, 8)] __aligned(8);
+static uint8_t gravity_buf[DECODE_BUF_SIZE(struct sensor_three_axis_data, 8)] __aligned(8);
+static uint8_t gbias_buf[DECODE_BUF_SIZE(struct sensor_three_axis_data, 8)] __aligned(8);
+
+#ifndef CONFIG_STREAM_FIFO_SCHED
+/* All frames of the FIFO drain being processed */
+static struct imu_batch single_batch;
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_CLOCK_ALIGN
+static struct clock_align clock_align[NUM_SENSORS];
+static struct clock_align_error clock_align_err[NUM_SENSORS];
+static struct timeline timeline;
+/* batches of different sensors can be aligned in parallel, the timeline is shared */
+static K_MUTEX_DEFINE(timeline_lock);
+
+static void timeline_print(const struct timeline_frame *frame, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	if (IS_ENABLED(CONFIG_STREAM_FIFO_TIMELINE_PRINT)) {
+		printk("MERGED %s %s %lluns (%" PRIq(6) ", %" PRIq(6) ", %" PRIq(6) ")\n",
+		       sensors[frame->sensor]->name, imu_chan_name[frame->chan],
+		       frame->sample.timestamp_ns,
+		       PRIq_arg(frame->sample.v[0], 6, frame->shift),
+		       PRIq_arg(frame->sample.v[1], 6, frame->shift),
+		       PRIq_arg(frame->sample.v[2], 6, frame->shift));
+	}
+}
+
+/* Called with timeline_lock held, the error statistics restart at every report */
+static void clock_align_report(void)
+{
+	for (int i = 0; i < NUM_SENSORS; i++) {
+		const struct clock_align *ca = &clock_align[i];
+		struct clock_align_error *err = &clock_align_err[i];
+
+		printk("clock align %s: drift %lld ppb, offset %lld ns",
+		       sensors[i]->name, ca->drift_ppb,
+		       ca->ref_uptime_ns - (int64_t)ca->ref_sensor_ns);
+
+#ifdef CONFIG_EMUL_IMU
+		uint64_t t0, t1;
+
+		/* true drift: uptime elapsed over one second of the sensor clock */
+		if (ca->valid &&
+		    emul_imu_to_uptime_ns(sensors[i], ca->ref_sensor_ns, &t0) == 0 &&
+		    emul_imu_to_uptime_ns(sensors[i], ca->ref_sensor_ns + NSEC_PER_SEC, &t1) == 0) {
+			printk(", drift error %lld ppb",
+			       ca->drift_ppb - ((int64_t)(t1 - t0) - (int64_t)NSEC_PER_SEC));
+		}
+#endif
+
+		if (err->count > 0) {
+			printk(", error mean %lld ns, mean abs %llu ns, max abs %llu ns",
+			       err->sum_ns / err->count, err->sum_abs_ns / err->count,
+			       err->max_abs_ns);
+		}
+		printk("\n");
+
+		*err = (struct clock_align_error){ 0 };
+	}
+
+	printk("timeline: %u frames merged, %u out of order, %u overflows\n",
+	       timeline.emitted, timeline.out_of_order, timeline.overflows);
+}
+
+static void align_batch(struct imu_batch *b)
+{
+	static uint32_t batches;
+	struct clock_align *ca = &clock_align[b->sensor];
+
+	struct clock_align_error err = { 0 };
+
+	clock_align_observe_batch(ca, b);
+
+#ifdef CONFIG_EMUL_IMU
+	/* the emulated sensor knows when each frame was really sampled */
+	const struct imu_sample *xl = imu_batch_samples(b, IMU_CHAN_XL);
+
+	for (uint16_t k = 0; ca->valid && k < b->chan[IMU_CHAN_XL].count; k++) {
+		uint64_t truth;
+
+		if (emul_imu_to_uptime_ns(sensors[b->sensor], xl[k].timestamp_ns, &truth) == 0) {
+			clock_align_error_add(&err, clock_align_to_uptime(ca, xl[k].timestamp_ns) -
+					      truth);
+		}
+	}
+#endif
+
+	clock_align_rewrite(ca, b);
+
+	k_mutex_lock(&timeline_lock, K_FOREVER);
+	clock_align_error_merge(&clock_align_err[b->sensor], &err);
+	timeline_push(&timeline, b);
+	timeline_release(&timeline, b->arrival_ns);
+
+	if (++batches % CONFIG_STREAM_FIFO_CLOCK_ALIGN_REPORT_INTERVAL == 0) {
+		clock_align_report();
+	}
+	k_mutex_unlock(&timeline_lock);
+}
+#endif /* CONFIG_STREAM_FIFO_CLOCK_ALIGN */
+
+#ifdef CONFIG_STREAM_FIFO_RESAMPLE
+static struct resample resamplers[NUM_SENSORS][2];
+static bool resampler_ready[NUM_SENSORS];
+/* setup failed and was reported, the sensor is not resampled */
+static bool resampler_failed[NUM_SENSORS];
+static struct imu_sample resampled[NUM_SENSORS][CONFIG_STREAM_FIFO_BATCH_SAMPLES];
+
+/* ODRs of the lis2dux12, lsm6dso and lsm6dsv16x families, rounded down */
+static const uint16_t standard_odr_hz[] = {
+	1, 3, 6, 7, 12, 15, 25, 26, 30, 50, 52, 60, 100, 104, 120, 200, 208, 240,
+	400, 416, 480, 800, 833, 960, 1666, 1920, 3333, 3840, 6667, 7680,
+};
+
+/*
+ * The measured rate is off the nominal one by the sensor clock drift, and
+ * once aligned by the uptime clock drift too: an exact ratio to it, like
+ * 100/931, needs far more taps than the nominal one. Use the ODR the sensor
+ * reports, or else the nearest standard ODR.
+ */
+static uint32_t resample_input_hz(const struct device *dev, uint32_t measured_hz)
+{
+	struct sensor_value odr;
+	uint32_t best = standard_odr_hz[0];
+
+	if (sensor_attr_get(dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY,
+			    &odr) == 0 && odr.val1 > 0) {
+		return odr.val1 + (odr.val2 >= 500000);
+	}
+
+	for (int i = 1; i < ARRAY_SIZE(standard_odr_hz); i++) {
+		if (abs((int32_t)standard_odr_hz[i] - (int32_t)measured_hz) <
+		    abs((int32_t)best - (int32_t)measured_hz)) {
+			best = standard_odr_hz[i];
+		}
+	}
+
+	return best;
+}
+
+/* Measure the input rate on the first drain and set up the XL and GY resamplers */
+static int resample_setup(const struct imu_batch *b)
+{
+	const struct imu_sample *xl = imu_batch_samples_const(b, IMU_CHAN_XL);
+	uint16_t n = b->chan[IMU_CHAN_XL].count;
+	struct resample_config cfg = {
+		.type = IS_ENABLED(CONFIG_STREAM_FIFO_RESAMPLE_CIC) ? RESAMPLE_CIC : RESAMPLE_FIR,
+		.order = CONFIG_STREAM_FIFO_RESAMPLE_CIC_ORDER,
+		.span = CONFIG_STREAM_FIFO_RESAMPLE_TAPS,
+		.cutoff_pct = CONFIG_STREAM_FIFO_RESAMPLE_CUTOFF,
+		.channels = 3,
+	};
+	uint64_t span_ns;
+	uint32_t measured_hz;
+	uint32_t in_hz;
+	int rc;
+
+	if (n < 2 || xl[n - 1].timestamp_ns <= xl[0].timestamp_ns) {
+		return -EAGAIN;
+	}
+
+	span_ns = xl[n - 1].timestamp_ns - xl[0].timestamp_ns;
+	measured_hz = ((uint64_t)(n - 1) * NSEC_PER_SEC + span_ns / 2) / span_ns;
+	in_hz = resample_input_hz(sensors[b->sensor], measured_hz);
+	resample_ratio(in_hz, CONFIG_STREAM_FIFO_RESAMPLE_HZ, &cfg.up, &cfg.down);
+
+	if (cfg.type == RESAMPLE_CIC && cfg.up != 1) {
+		printk("%s: %u Hz -> %u Hz is not an integer ratio, using FIR\n",
+		       sensors[b->sensor]->name, in_hz, CONFIG_STREAM_FIFO_RESAMPLE_HZ);
+		cfg.type = RESAMPLE_FIR;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(resamplers[0]); i++) {
+		rc = resample_init(&resamplers[b->sensor][i], &cfg);
+		if (rc != 0) {
+			printk("%s: resampler %u/%u not supported (%d), not resampling\n",
+			       sensors[b->sensor]->name, cfg.up, cfg.down, rc);
+			resampler_failed[b->sensor] = true;
+			return rc;
+		}
+	}
+
+	printk("%s: resampling %u Hz (measured %u Hz) -> %u Hz (%s %u/%u)\n",
+	       sensors[b->sensor]->name, in_hz, measured_hz, CONFIG_STREAM_FIFO_RESAMPLE_HZ,
+	       (cfg.type == RESAMPLE_CIC) ? "CIC" : "FIR", cfg.up, cfg.down);
+	resampler_ready[b->sensor] = true;
+
+	return 0;
+}
+
+static void resample_batch(const struct imu_batch *b)
+{
+	static const enum imu_chan chans[] = { IMU_CHAN_XL, IMU_CHAN_GY };
+	struct imu_sample *out = resampled[b->sensor];
+
+	if (!resampler_ready[b->sensor] &&
+	    (resampler_failed[b->sensor] || resample_setup(b) != 0)) {
+		return;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(chans); i++) {
+		uint16_t n = resample_process(&resamplers[b->sensor][i],
+					      imu_batch_samples_const(b, chans[i]),
+					      b->chan[chans[i]].count, out,
+					      ARRAY_SIZE(resampled[0]));
+
+		for (uint16_t k = 0; IS_ENABLED(CONFIG_STREAM_FIFO_RESAMPLE_PRINT) && k < n; k++) {
+			int8_t shift = b->chan[chans[i]].shift;
+
+			printk("%s@%uHz data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
+			       ", %" PRIq(6) ")\n", (i == 0) ? "XL" : "GY",
+			       CONFIG_STREAM_FIFO_RESAMPLE_HZ, sensors[b->sensor]->name,
+			       out[k].timestamp_ns,
+			       PRIq_arg(out[k].v[0], 6, shift),
+			       PRIq_arg(out[k].v[1], 6, shift),
+			       PRIq_arg(out[k].v[2], 6, shift));
+		}
+	}
+}
+#endif /* CONFIG_STREAM_FIFO_RESAMPLE */
+
+#ifdef CONFIG_STREAM_FIFO_OUTPUT_SUMMARY
+static struct summary_window summary[NUM_SENSORS];
+static uint32_t summary_lost[NUM_SENSORS];
+
+K_MSGQ_DEFINE(summary_msgq, sizeof(struct summary_window),
+	      CONFIG_STREAM_FIFO_SUMMARY_QUEUE_DEPTH, 8);
+
+/* Formats and prints the summaries, so console I/O stays off the acquisition thread */
+static void summary_thread(void *p1, void *p2, void *p3)
+{
+	static struct summary_window win;
+	static char line[1024];
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (1) {
+		k_msgq_get(&summary_msgq, &win, K_FOREVER);
+		summary_format(&win, line, sizeof(line));
+		printk("%s\n", line);
+	}
+}
+
+K_THREAD_DEFINE(summary_tid, CONFIG_STREAM_FIFO_SUMMARY_STACK_SIZE, summary_thread,
+		NULL, NULL, NULL, CONFIG_STREAM_FIFO_SUMMARY_PRIORITY, 0, 0);
+
+static void summary_batch(const struct imu_batch *b)
+{
+	struct summary_window *win = &summary[b->sensor];
+
+	if (win->events == 0) {
+		summary_window_reset(win, sensors[b->sensor]->name, imu_chan_name,
+				     IMU_CHAN_COUNT);
+		win->start_ns = b->arrival_ns;
+	}
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		summary_add(win, i, imu_batch_samples_const(b, i), b->chan[i].count,
+			    imu_chan_values[i], b->chan[i].shift);
+	}
+
+	win->events++;
+	win->dropped += b->dropped;
+	win->end_ns = b->arrival_ns;
+
+	if (win->end_ns - win->start_ns <
+	    (uint64_t)CONFIG_STREAM_FIFO_SUMMARY_WINDOW_MS * NSEC_PER_MSEC) {
+		return;
+	}
+
+	/* never block acquisition on the console, count what the formatter missed */
+	win->lost = summary_lost[b->sensor];
+	if (k_msgq_put(&summary_msgq, win, K_NO_WAIT) == 0) {
+		summary_lost[b->sensor] = 0;
+	} else {
+		summary_lost[b->sensor]++;
+	}
+
+	win->events = 0;
+}
+#endif /* CONFIG_STREAM_FIFO_OUTPUT_SUMMARY */
+
+#ifdef CONFIG_STREAM_FIFO_CPU_STATS
+static struct {
+	uint64_t acq_cycles;
+	uint64_t fmt_cycles;
+	uint32_t events;
+	uint32_t frames;
+#ifdef CONFIG_STREAM_FIFO_CPU_STATS_COMPARE
+	/* acquisition and formatter cycles per frame of the per-frame output */
+	uint64_t frames_cycles;
+	bool compared;
+#endif
+} cpu_stats;
+
+static uint64_t cpu_stats_thread_cycles(k_tid_t tid)
+{
+	k_thread_runtime_stats_t rt;
+
+	if (k_thread_runtime_stats_get(tid, &rt) != 0) {
+		return 0;
+	}
+
+	return rt.execution_cycles;
+}
+
+static void cpu_stats_start(void)
+{
+	cpu_stats.acq_cycles = cpu_stats_thread_cycles(k_current_get());
+#ifdef CONFIG_STREAM_FIFO_OUTPUT_SUMMARY
+	cpu_stats.fmt_cycles = cpu_stats_thread_cycles(summary_tid);
+#endif
+	cpu_stats.events = 0;
+	cpu_stats.frames = 0;
+}
+
+/* Account one FIFO event, report the cycles spent per event and per frame */
+static void cpu_stats_event(uint16_t frames)
+{
+	uint64_t acq, fmt = 0;
+
+	cpu_stats.events++;
+	cpu_stats.frames += frames;
+	if (cpu_stats.events < CONFIG_STREAM_FIFO_CPU_STATS_INTERVAL) {
+		return;
+	}
+
+	acq = cpu_stats_thread_cycles(k_current_get()) - cpu_stats.acq_cycles;
+#ifdef CONFIG_STREAM_FIFO_OUTPUT_SUMMARY
+	fmt = cpu_stats_thread_cycles(summary_tid) - cpu_stats.fmt_cycles;
+#endif
+
+	printk("cpu %s: %u events, %u frames, acquisition %llu cycles/event "
+	       "%llu cycles/frame, formatter %llu cycles/event\n",
+	       PRINT_FRAMES ? "frames" : "summary", cpu_stats.events, cpu_stats.frames,
+	       acq / cpu_stats.events, acq / MAX(cpu_stats.frames, 1),
+	       fmt / cpu_stats.events);
+
+#ifdef CONFIG_STREAM_FIFO_CPU_STATS_COMPARE
+	uint64_t per_frame = (acq + fmt) / MAX(cpu_stats.frames, 1);
+
+	if (print_frames) {
+		cpu_stats.frames_cycles = per_frame;
+		print_frames = false;
+	} else if (!cpu_stats.compared) {
+		printk("cpu compare: per-frame %llu cycles/frame, summary %llu cycles/frame, "
+		       "%lld%% less\n", cpu_stats.frames_cycles, per_frame,
+		       100 - (int64_t)(per_frame * 100 / MAX(cpu_stats.frames_cycles, 1)));
+		cpu_stats.compared = true;
+	}
+#endif
+
+	/* restart after the report so its own printk is not accounted */
+	cpu_stats_start();
+}
+#endif /* CONFIG_STREAM_FIFO_CPU_STATS */
+
+#ifdef CONFIG_STREAM_FIFO_FUSION
+static struct fusion fusion[NUM_SENSORS];
+static struct fusion_accuracy fusion_acc[NUM_SENSORS];
+static struct imu_sample fusion_quat[NUM_SENSORS][CONFIG_STREAM_FIFO_BATCH_SAMPLES];
+static struct imu_sample fusion_gravity[NUM_SENSORS][CONFIG_STREAM_FIFO_BATCH_SAMPLES];
+
+static struct {
+	uint64_t cycles;
+	uint32_t samples;
+	uint32_t batches;
+} fusion_stats[NUM_SENSORS];
+
+static const char *fusion_algo_name(void)
+{
+	return IS_ENABLED(CONFIG_STREAM_FIFO_FUSION_MADGWICK) ? "madgwick" : "mahony";
+}
+
+static void fusion_setup(void)
+{
+	const struct fusion_config cfg = {
+		.algo = IS_ENABLED(CONFIG_STREAM_FIFO_FUSION_MADGWICK) ? FUSION_MADGWICK
+								       : FUSION_MAHONY,
+		.gain_q16 = ((uint64_t)CONFIG_STREAM_FIFO_FUSION_GAIN_MILLI << 16) / 1000,
+#ifdef CONFIG_STREAM_FIFO_FUSION_KI_MILLI
+		.ki_q16 = ((uint64_t)CONFIG_STREAM_FIFO_FUSION_KI_MILLI << 16) / 1000,
+#endif
+	};
+
+	for (int i = 0; i < NUM_SENSORS; i++) {
+		fusion_init(&fusion[i], &cfg);
+	}
+}
+
+/* Print an angle in degrees with three decimals */
+#define FUSION_MDEG(deg) (uint32_t)((deg) * 1000.0f) / 1000, (uint32_t)((deg) * 1000.0f) % 1000
+
+static void fusion_report(uint8_t sensor)
+{
+	const struct fusion_accuracy *acc = &fusion_acc[sensor];
+	uint32_t cycles_x100 = (fusion_stats[sensor].cycles * 100) /
+			       MAX(fusion_stats[sensor].samples, 1);
+	float rot_mean = acc->rot_sum / MAX(acc->rot_count, 1);
+	float tilt_mean = acc->tilt_sum / MAX(acc->tilt_count, 1);
+
+	printk("fusion %s (%s): %u samples, %u.%02u cycles/sample, "
+	       "rotation error mean %u.%03u max %u.%03u deg (%u ref), "
+	       "tilt error mean %u.%03u max %u.%03u deg (%u ref)\n",
+	       sensors[sensor]->name, fusion_algo_name(), fusion_stats[sensor].samples,
+	       cycles_x100 / 100, cycles_x100 % 100,
+	       FUSION_MDEG(rot_mean), FUSION_MDEG(acc->rot_max), acc->rot_count,
+	       FUSION_MDEG(tilt_mean), FUSION_MDEG(acc->tilt_max), acc->tilt_count);
+
+	/* the heading offset is kept, it only needs to be measured once */
+	fusion_acc[sensor].rot_count = 0;
+	fusion_acc[sensor].tilt_count = 0;
+	fusion_acc[sensor].rot_sum = 0.0f;
+	fusion_acc[sensor].rot_max = 0.0f;
+	fusion_acc[sensor].tilt_sum = 0.0f;
+	fusion_acc[sensor].tilt_max = 0.0f;
+	fusion_stats[sensor].cycles = 0;
+	fusion_stats[sensor].samples = 0;
+}
+
+static void fusion_batch(const struct imu_batch *b)
+{
+	struct imu_sample *quat = fusion_quat[b->sensor];
+	struct imu_sample *grav = fusion_gravity[b->sensor];
+	uint32_t start;
+	uint16_t n;
+
+	start = k_cycle_get_32();
+	n = fusion_process(&fusion[b->sensor],
+			   imu_batch_samples_const(b, IMU_CHAN_XL), b->chan[IMU_CHAN_XL].count,
+			   imu_batch_samples_const(b, IMU_CHAN_GY), b->chan[IMU_CHAN_GY].count,
+			   b->chan[IMU_CHAN_GY].shift, quat, grav,
+			   CONFIG_STREAM_FIFO_BATCH_SAMPLES);
+	fusion_stats[b->sensor].cycles += k_cycle_get_32() - start;
+	fusion_stats[b->sensor].samples += b->chan[IMU_CHAN_GY].count;
+
+	/* reference frames of the device sensor fusion, if it is running */
+	fusion_accuracy_add(&fusion_acc[b->sensor], quat, grav, n,
+			    imu_batch_samples_const(b, IMU_CHAN_ROT), b->chan[IMU_CHAN_ROT].count,
+			    b->chan[IMU_CHAN_ROT].shift,
+			    imu_batch_samples_const(b, IMU_CHAN_GRAVITY),
+			    b->chan[IMU_CHAN_GRAVITY].count);
+
+	for (uint16_t k = 0; IS_ENABLED(CONFIG_STREAM_FIFO_FUSION_PRINT) && k < n; k++) {
+		printk("fusion data for %s %lluns (%" PRIq(6) ", %" PRIq(6) ", %" PRIq(6)
+		       ", %" PRIq(6) ")\n", sensors[b->sensor]->name, quat[k].timestamp_ns,
+		       PRIq_arg(quat[k].v[0], 6, FUSION_Q_SHIFT),
+		       PRIq_arg(quat[k].v[1], 6, FUSION_Q_SHIFT),
+		       PRIq_arg(quat[k].v[2], 6, FUSION_Q_SHIFT),
+		       PRIq_arg(quat[k].v[3], 6, FUSION_Q_SHIFT));
+	}
+
+	if (++fusion_stats[b->sensor].batches % CONFIG_STREAM_FIFO_FUSION_REPORT_INTERVAL == 0) {
+		fusion_report(b->sensor);
+	}
+}
+#endif /* CONFIG_STREAM_FIFO_FUSION */
+
+#ifdef CONFIG_STREAM_FIFO_HISTORY
+static struct history history[NUM_SENSORS];
+static uint32_t history_batches[NUM_SENSORS];
+
+/* Spans reported for each sensor, queried back from the latest frame */
+static const uint32_t history_spans_ms[] = { 1000, 10000, 600000 };
+
+static void history_report(uint8_t sensor)
+{
+	const struct history *h = &history[sensor];
+
+	for (int i = 0; i < ARRAY_SIZE(history_spans_ms); i++) {
+		uint64_t span_ns = (uint64_t)history_spans_ms[i] * NSEC_PER_MSEC;
+		uint64_t to = h->last_ns + 1;
+		struct history_result r;
+
+		if (history_query(h, (to > span_ns) ? (to - span_ns) : 0, to, &r) != 0) {
+			continue;
+		}
+
+		printk("history %s last %u ms: %u frames over %llu ms, mean (%" PRIq(6) ", %"
+		       PRIq(6) ", %" PRIq(6) ") min (%" PRIq(6) ", %" PRIq(6) ", %" PRIq(6)
+		       ") max (%" PRIq(6) ", %" PRIq(6) ", %" PRIq(6) ")\n",
+		       sensors[sensor]->name, history_spans_ms[i], r.count,
+		       (r.end_ns - r.start_ns) / NSEC_PER_MSEC,
+		       PRIq_arg(r.mean[0], 6, r.shift), PRIq_arg(r.mean[1], 6, r.shift),
+		       PRIq_arg(r.mean[2], 6, r.shift), PRIq_arg(r.min[0], 6, r.shift),
+		       PRIq_arg(r.min[1], 6, r.shift), PRIq_arg(r.min[2], 6, r.shift),
+		       PRIq_arg(r.max[0], 6, r.shift), PRIq_arg(r.max[1], 6, r.shift),
+		       PRIq_arg(r.max[2], 6, r.shift));
+	}
+}
+
+static void history_batch(const struct imu_batch *b)
+{
+	history_add(&history[b->sensor], imu_batch_samples_const(b, IMU_CHAN_XL),
+		    b->chan[IMU_CHAN_XL].count, b->chan[IMU_CHAN_XL].shift);
+
+	if (++history_batches[b->sensor] % CONFIG_STREAM_FIFO_HISTORY_REPORT_INTERVAL == 0) {
+		history_report(b->sensor);
+	}
+}
+#endif /* CONFIG_STREAM_FIFO_HISTORY */
+
+#ifdef CONFIG_STREAM_FIFO_SHED
+static struct shed shed;
+
+static const uint8_t shed_prio[IMU_CHAN_COUNT] = {
+	[IMU_CHAN_XL] = CONFIG_STREAM_FIFO_SHED_PRIO_XL,
+	[IMU_CHAN_GY] = CONFIG_STREAM_FIFO_SHED_PRIO_GY,
+	[IMU_CHAN_TEMP] = CONFIG_STREAM_FIFO_SHED_PRIO_TEMP,
+	[IMU_CHAN_ROT] = CONFIG_STREAM_FIFO_SHED_PRIO_ROT,
+	[IMU_CHAN_GRAVITY] = CONFIG_STREAM_FIFO_SHED_PRIO_GRAVITY,
+	[IMU_CHAN_GBIAS] = CONFIG_STREAM_FIFO_SHED_PRIO_GBIAS,
+};
+
+/* Emulated processing cost per frame, to overload the consumer on demand */
+static void shed_test_load(const struct imu_batch *b)
+{
+	uint32_t frames = 0;
+
+	if (CONFIG_STREAM_FIFO_SHED_TEST_COST_US == 0 ||
+	    (CONFIG_STREAM_FIFO_SHED_TEST_SECONDS > 0 &&
+	     b->arrival_ns >= (uint64_t)CONFIG_STREAM_FIFO_SHED_TEST_SECONDS * NSEC_PER_SEC)) {
+		return;
+	}
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		frames += b->chan[i].count;
+	}
+
+	k_busy_wait(frames * CONFIG_STREAM_FIFO_SHED_TEST_COST_US);
+}
+#endif /* CONFIG_STREAM_FIFO_SHED */
+
+/*
+ * Run the processing stages on the frames of one FIFO drain. With
+ * CONFIG_STREAM_FIFO_SCHED this runs on the worker threads: batches of one
+ * sensor never run concurrently, so per-sensor state needs no locking.
+ */
+static void process_batch(struct imu_batch *b)
+{
+#ifdef CONFIG_STREAM_FIFO_CLOCK_ALIGN
+	align_batch(b);
+#endif
+#ifdef CONFIG_STREAM_FIFO_RESAMPLE
+	resample_batch(b);
+#endif
+#ifdef CONFIG_STREAM_FIFO_SHED
+	/* after the stages that expect the sensor rate */
+	shed_decimate(b);
+#endif
+#ifdef CONFIG_STREAM_FIFO_OUTPUT_SUMMARY
+	if (!PRINT_FRAMES) {
+		summary_batch(b);
+	}
+#endif
+#ifdef CONFIG_STREAM_FIFO_FUSION
+	fusion_batch(b);
+#endif
+#ifdef CONFIG_STREAM_FIFO_HISTORY
+	history_batch(b);
+#endif
+#ifdef CONFIG_STREAM_FIFO_SHED
+	shed_test_load(b);
+#endif
+	ARG_UNUSED(b);
+}
+
+#ifdef CONFIG_STREAM_FIFO_SCHED
+static struct sched sched;
+
+static void sched_process(struct imu_batch *b, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	process_batch(b);
+}
+#endif
 
 static int print_accels_stream(const struct device *dev, struct rtio_iodev *iodev)
 {
@@ -71,18 +757,66 @@ static int print_accels_stream(const struct device *dev, struct rtio_iodev *iode
 	struct sensor_three_axis_data *gravity_data = (struct sensor_three_axis_data *)gravity_buf;
 	struct sensor_three_axis_data *gbias_data = (struct sensor_three_axis_data *)gbias_buf;
 
-	/* Start the streams */
+	/* Start the streams, the userdata identifies the sensor of each completion */
 	for (int i = 0; i < NUM_SENSORS; i++) {
 		printk("sensor_stream\n");
-		sensor_stream(iodevs[i], &stream_ctx, NULL, &handles[i]);
+		sensor_stream(iodevs[i], &stream_ctx, (void *)&sensors[i], &handles[i]);
 	}
 
+#ifdef CONFIG_STREAM_FIFO_CPU_STATS
+	cpu_stats_start();
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SHED
+	/* completions taken in a row without waiting for one */
+	uint32_t queued = 0;
+#endif
+
 	while (1) {
+#ifdef CONFIG_STREAM_FIFO_SHED
+		cqe = rtio_cqe_consume(&stream_ctx);
+
+		if (cqe == NULL) {
+			queued = 0;
+			cqe = rtio_cqe_consume_block(&stream_ctx);
+		} else {
+			queued++;
+		}
+
+		/*
+		 * Sensors on the same tick queue up one drain each even when the
+		 * consumer keeps up: it is behind once more than that was waiting.
+		 */
+		bool behind = (queued >= NUM_SENSORS);
+#else
 		cqe = rtio_cqe_consume_block(&stream_ctx);
+#endif
+
+		uint64_t arrival_ns = k_ticks_to_ns_floor64(k_uptime_ticks());
 
 		if (cqe->result != 0) {
-			printk("async read failed %d\n", cqe->result);
-			return cqe->result;
+			const struct device *const *failed = cqe->userdata;
+			int result = cqe->result;
+
+#ifdef CONFIG_STREAM_FIFO_MEMPOOL_STATS
+			mempool_stats_on_cqe(&stream_pool_stats, result, 0);
+			mempool_stats_print(&stream_pool_stats);
+#endif
+			rtio_cqe_release(&stream_ctx, cqe);
+
+			/* no buffer for a drain ends the stream, its frames wait in the FIFO */
+			if (result == -ENOMEM) {
+				uint8_t failed_idx = failed - sensors;
+
+				printk("%s: no mempool buffer, restarting the stream\n",
+				       (*failed)->name);
+				sensor_stream(iodevs[failed_idx], &stream_ctx, (void *)failed,
+					      &handles[failed_idx]);
+				continue;
+			}
+
+			printk("async read failed %d\n", result);
+			return result;
 		}
 
 		rc = rtio_cqe_get_mempool_buffer(&stream_ctx, cqe, &buf, &buf_len);
@@ -92,7 +826,17 @@ static int print_accels_stream(const struct device *dev, struct rtio_iodev *iode
 			return rc;
 		}
 
-		const struct device *sensor = dev;
+#ifdef CONFIG_STREAM_FIFO_MEMPOOL_STATS
+		mempool_stats_on_cqe(&stream_pool_stats, 0, buf_len);
+
+		if (stream_pool_stats.buffers % CONFIG_STREAM_FIFO_MEMPOOL_STATS_INTERVAL == 0) {
+			mempool_stats_print(&stream_pool_stats);
+		}
+#endif
+
+		const struct device *const *entry = cqe->userdata;
+		const struct device *sensor = *entry;
+		uint8_t sensor_idx = entry - sensors;
 
 		rtio_cqe_release(&stream_ctx, cqe);
 
@@ -124,16 +868,48 @@ static int print_accels_stream(const struct device *dev, struct rtio_iodev *iode
 			return rc;
 		}
 
-		frame_count = xl_count + gy_count + tp_count;
-		frame_count += rot_vect_count + gravity_count + gbias_count;
+		uint16_t counts[IMU_CHAN_COUNT] = {
+			[IMU_CHAN_XL] = xl_count, [IMU_CHAN_GY] = gy_count,
+			[IMU_CHAN_TEMP] = tp_count, [IMU_CHAN_ROT] = rot_vect_count,
+			[IMU_CHAN_GRAVITY] = gravity_count, [IMU_CHAN_GBIAS] = gbias_count,
+		};
+
+#ifdef CONFIG_STREAM_FIFO_SHED
+		const struct shed_action *action =
+			shed_update(&shed, arrival_ns, behind,
+				    decoder->has_trigger(buf, SENSOR_TRIG_FIFO_FULL));
+
+		if (action != NULL) {
+			shed_print(&shed, action);
+		}
+
+		/* the dropped channels are not even decoded */
+		shed_filter_counts(&shed, counts);
+#endif
+
+		frame_count = 0;
+		for (int j = 0; j < IMU_CHAN_COUNT; j++) {
+			frame_count += counts[j];
+		}
+
+#ifdef CONFIG_STREAM_FIFO_SCHED
+		/* waits for a worker to return a batch when all are queued */
+		struct imu_batch *batch = sched_batch_alloc(K_FOREVER);
+#else
+		struct imu_batch *batch = &single_batch;
+#endif
+
+		imu_batch_reset(batch, sensor_idx, arrival_ns, counts);
 
 		/* If a tap has occurred lets print it out */
 		if (decoder->has_trigger(buf, SENSOR_TRIG_TAP)) {
-			printk("Tap! Sensor %s\n", dev->name);
+			printk("Tap! Sensor %s\n", sensor->name);
 		}
 
 		/* Decode all available sensor FIFO frames */
-		printk("FIFO count - %d\n", frame_count);
+		if (PRINT_FRAMES) {
+			printk("FIFO count - %d\n", frame_count);
+		}
 
 		int i = 0;
 
@@ -141,66 +917,93 @@ static int print_accels_stream(const struct device *dev, struct rtio_iodev *iode
 			int8_t c = 0;
 
 			/* decode and print Accelerometer FIFO frames */
-			c = decoder->decode(buf, accel_chan, &accel_fit, 8, accel_data);
+			c = (counts[IMU_CHAN_XL] > 0) ?
+			    decoder->decode(buf, accel_chan, &accel_fit, 8, accel_data) : 0;
 
-			for (int k = 0; k < c; k++) {
+			for (int k = 0; PRINT_FRAMES && k < c; k++) {
 				printk("XL data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
-				       ", %" PRIq(6) ")\n", dev->name,
+				       ", %" PRIq(6) ")\n", sensor->name,
 				       PRIsensor_three_axis_data_arg(*accel_data, k));
 			}
+			imu_batch_add_three_axis(batch, IMU_CHAN_XL, accel_data, c);
 			i += c;
 
 			/* decode and print Gyroscope FIFO frames */
-			c = decoder->decode(buf, gyro_chan, &gyro_fit, 8, gyro_data);
+			c = (counts[IMU_CHAN_GY] > 0) ?
+			    decoder->decode(buf, gyro_chan, &gyro_fit, 8, gyro_data) : 0;
 
-			for (int k = 0; k < c; k++) {
+			for (int k = 0; PRINT_FRAMES && k < c; k++) {
 				printk("GY data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
-				       ", %" PRIq(6) ")\n", dev->name,
+				       ", %" PRIq(6) ")\n", sensor->name,
 				       PRIsensor_three_axis_data_arg(*gyro_data, k));
 			}
+			imu_batch_add_three_axis(batch, IMU_CHAN_GY, gyro_data, c);
 			i += c;
 
 			/* decode and print Temperature FIFO frames */
-			c = decoder->decode(buf, temp_chan, &temp_fit, 4, temp_data);
+			c = (counts[IMU_CHAN_TEMP] > 0) ?
+			    decoder->decode(buf, temp_chan, &temp_fit, 4, temp_data) : 0;
 
-			for (int k = 0; k < c; k++) {
-				printk("TP data for %s %lluns %s%d.%d °C\n", dev->name,
+			for (int k = 0; PRINT_FRAMES && k < c; k++) {
+				printk("TP data for %s %lluns %s%d.%d °C\n", sensor->name,
 				       PRIsensor_q31_data_arg(*temp_data, k));
 			}
+			imu_batch_add_q31(batch, IMU_CHAN_TEMP, temp_data, c);
 			i += c;
 
 			/* decode and print Game Rotation Vector FIFO frames */
-			c = decoder->decode(buf, rot_vector_chan, &rot_vect_fit, 8, rot_vect_data);
+			c = (counts[IMU_CHAN_ROT] > 0) ?
+			    decoder->decode(buf, rot_vector_chan, &rot_vect_fit, 8, rot_vect_data)
+			    : 0;
 
-			for (int k = 0; k < c; k++) {
+			for (int k = 0; PRINT_FRAMES && k < c; k++) {
 				printk("ROT data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
-				       ", %" PRIq(6) ", %" PRIq(6) ") \n", dev->name,
+				       ", %" PRIq(6) ", %" PRIq(6) ") \n", sensor->name,
 				       PRIsensor_game_rotation_vector_data_arg(*rot_vect_data, k));
 			}
+			imu_batch_add_rotation(batch, IMU_CHAN_ROT, rot_vect_data, c);
 			i += c;
 
 			/* decode and print Gravity Vector FIFO frames */
-			c = decoder->decode(buf, gravity_chan, &gravity_fit, 8, gravity_data);
+			c = (counts[IMU_CHAN_GRAVITY] > 0) ?
+			    decoder->decode(buf, gravity_chan, &gravity_fit, 8, gravity_data) : 0;
 
-			for (int k = 0; k < c; k++) {
+			for (int k = 0; PRINT_FRAMES && k < c; k++) {
 				printk("GV data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
-				       ", %" PRIq(6) ") \n", dev->name,
+				       ", %" PRIq(6) ") \n", sensor->name,
 				       PRIsensor_three_axis_data_arg(*gravity_data, k));
 			}
+			imu_batch_add_three_axis(batch, IMU_CHAN_GRAVITY, gravity_data, c);
 			i += c;
 
 			/* decode and print Gyroscope GBIAS FIFO frames */
-			c = decoder->decode(buf, gbias_chan, &gbias_fit, 8, gbias_data);
+			c = (counts[IMU_CHAN_GBIAS] > 0) ?
+			    decoder->decode(buf, gbias_chan, &gbias_fit, 8, gbias_data) : 0;
 
-			for (int k = 0; k < c; k++) {
+			for (int k = 0; PRINT_FRAMES && k < c; k++) {
 				printk("GY GBIAS data for %s %lluns (%" PRIq(6) ", %" PRIq(6)
-				       ", %" PRIq(6) ") \n", dev->name,
+				       ", %" PRIq(6) ") \n", sensor->name,
 				       PRIsensor_three_axis_data_arg(*gbias_data, k));
 			}
+			imu_batch_add_three_axis(batch, IMU_CHAN_GBIAS, gbias_data, c);
 			i += c;
 		}
 
 		rtio_release_buffer(&stream_ctx, buf, buf_len);
+
+#ifdef CONFIG_STREAM_FIFO_SHED
+		shed_mark_decimation(&shed, batch);
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SCHED
+		sched_submit(&sched, batch);
+#else
+		process_batch(batch);
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_CPU_STATS
+		cpu_stats_event(frame_count);
+#endif
 	}
 
 	return rc;
@@ -240,6 +1043,64 @@ int main(void)
 		check_sensor_is_off(sensors[i]);
 	}
 
+#ifdef CONFIG_STREAM_FIFO_BUS_PROF
+	bus_prof_init(CONFIG_STREAM_FIFO_BUS_PROF_INTERVAL_MS);
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_MEMPOOL_STATS
+	mempool_stats_init(&stream_pool_stats, &stream_ctx, "stream_ctx");
+	mempool_report_sizing();
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_RESAMPLE_BENCH
+	resample_bench();
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SCHED_BENCH
+	sched_bench();
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_HISTORY_BENCH
+	history_bench();
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_CLOCK_ALIGN
+	for (int i = 0; i < NUM_SENSORS; i++) {
+		clock_align_init(&clock_align[i]);
+	}
+	timeline_init(&timeline, NUM_SENSORS, timeline_print, NULL);
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_FUSION
+	fusion_setup();
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_HISTORY
+	for (int i = 0; i < NUM_SENSORS; i++) {
+		history_init(&history[i], 3, CONFIG_STREAM_FIFO_HISTORY_BUCKET_MS,
+			     CONFIG_STREAM_FIFO_HISTORY_FACTOR);
+	}
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SHED
+	shed_init(&shed, shed_prio, CONFIG_STREAM_FIFO_SHED_MAX_DECIMATION,
+		  CONFIG_STREAM_FIFO_SHED_HOLD_MS, CONFIG_STREAM_FIFO_SHED_RESTORE_MS,
+		  k_ticks_to_ns_floor64(k_uptime_ticks()));
+	printk("shed: %u levels, hold %u ms, restore %u ms\n", shed.num_levels,
+	       CONFIG_STREAM_FIFO_SHED_HOLD_MS, CONFIG_STREAM_FIFO_SHED_RESTORE_MS);
+#endif
+
+#ifdef CONFIG_STREAM_FIFO_SCHED
+	ret = sched_init(&sched, CONFIG_STREAM_FIFO_SCHED_WORKERS,
+			 IS_ENABLED(CONFIG_STREAM_FIFO_SCHED_STEAL), sched_process, NULL);
+	if (ret != 0) {
+		printk("sched_init failed %d\n", ret);
+		return 0;
+	}
+	printk("sched: %u workers on %u CPUs, stealing %s\n", sched.num_workers,
+	       arch_num_cpus(), IS_ENABLED(CONFIG_STREAM_FIFO_SCHED_STEAL) ? "on" : "off");
+#endif
+
 	while (1) {
 		for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
 			ret = print_accels_stream(sensors[i], iodevs[i]);
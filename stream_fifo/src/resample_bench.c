@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "resample.h"
+#include "resample_bench.h"
+
+#define BENCH_BATCH	64
+#define BENCH_BATCHES	32
+
+struct resample_bench_case {
+	const char *name;
+	uint32_t in_hz;
+	struct resample_config cfg;
+};
+
+static const struct resample_bench_case bench_cases[] = {
+	{ "CIC 200->50 Hz order 3", 200,
+	  { .type = RESAMPLE_CIC, .up = 1, .down = 4, .order = 3, .channels = 3 } },
+	{ "FIR 100->50 Hz", 100,
+	  { .type = RESAMPLE_FIR, .up = 1, .down = 2, .span = 16,
+	    .cutoff_pct = 90, .channels = 3 } },
+	{ "FIR 480->50 Hz", 480,
+	  { .type = RESAMPLE_FIR, .up = 5, .down = 48, .span = 16,
+	    .cutoff_pct = 90, .channels = 3 } },
+	{ "FIR 960->100 Hz", 960,
+	  { .type = RESAMPLE_FIR, .up = 5, .down = 48, .span = 16,
+	    .cutoff_pct = 90, .channels = 3 } },
+	{ "FIR 60->100 Hz", 60,
+	  { .type = RESAMPLE_FIR, .up = 5, .down = 3, .span = 8,
+	    .cutoff_pct = 90, .channels = 3 } },
+};
+
+/*
+ * Worst gain of the FIR prototype, relative to DC, over the band that folds
+ * onto the passband at the lower rate: from that rate minus the cutoff up to
+ * the Nyquist rate of the upsampled domain. Sampled four times per sidelobe.
+ */
+static int resample_bench_stopband(const struct resample *rs, uint32_t in_hz,
+				   uint32_t *from_hz)
+{
+	const struct resample_config *cfg = &rs->cfg;
+	uint16_t ntaps = rs->fir.ntaps;
+	uint32_t taps = cfg->up * ntaps;
+	float fs = (float)in_hz * cfg->up;
+	float from = fs / MAX(cfg->up, cfg->down) * (1.0f - cfg->cutoff_pct / 200.0f);
+	uint32_t points = 2 * taps;
+	float dc = 0.0f;
+	float worst = 0.0f;
+
+	for (uint32_t n = 0; n < taps; n++) {
+		dc += rs->fir.taps[n];
+	}
+
+	for (uint32_t j = 0; j <= points; j++) {
+		float w = 2.0f * (float)M_PI * (from + (fs / 2.0f - from) * j / points) / fs;
+		float c = cosf(w), s = sinf(w);
+		float zr = 1.0f, zi = 0.0f;
+		float re = 0.0f, im = 0.0f;
+
+		/* h[n] = taps[n % up][n / up], z = e^(-jwn) by rotation */
+		for (uint32_t n = 0; n < taps; n++) {
+			float h = rs->fir.taps[(n % cfg->up) * ntaps + n / cfg->up];
+			float t = zr * c + zi * s;
+
+			re += h * zr;
+			im += h * zi;
+			zi = zi * c - zr * s;
+			zr = t;
+		}
+
+		worst = MAX(worst, sqrtf(re * re + im * im));
+	}
+
+	*from_hz = lroundf(from);
+
+	return (worst > 0.0f) ? (int)lroundf(20.0f * log10f(worst / dc)) : -200;
+}
+
+static struct resample bench_rs;
+static struct imu_sample bench_in[BENCH_BATCH];
+static struct imu_sample bench_out[BENCH_BATCH * 2];
+
+void resample_bench(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(bench_cases); i++) {
+		const struct resample_bench_case *bc = &bench_cases[i];
+		uint32_t period_ns = NSEC_PER_SEC / bc->in_hz;
+		uint64_t cycles = 0, ts = 0;
+		uint32_t outputs = 0;
+
+		if (resample_init(&bench_rs, &bc->cfg) != 0) {
+			printk("resample %s: unsupported\n", bc->name);
+			continue;
+		}
+
+		for (int b = 0; b < BENCH_BATCHES; b++) {
+			uint32_t start;
+
+			/* triangle waves, different on every axis */
+			for (int k = 0; k < BENCH_BATCH; k++) {
+				int32_t tri = (int32_t)((b * BENCH_BATCH + k) % 64) - 32;
+
+				bench_in[k].timestamp_ns = ts;
+				bench_in[k].v[0] = tri << 24;
+				bench_in[k].v[1] = -tri << 23;
+				bench_in[k].v[2] = (tri << 22) + BIT(30);
+				ts += period_ns;
+			}
+
+			start = k_cycle_get_32();
+			outputs += resample_process(&bench_rs, bench_in, BENCH_BATCH, bench_out,
+						    ARRAY_SIZE(bench_out));
+			cycles += k_cycle_get_32() - start;
+		}
+
+		uint32_t per_sample_x100 = (cycles * 100) / (BENCH_BATCH * BENCH_BATCHES);
+
+		printk("resample %s: %u.%02u cycles/input sample, %u outputs", bc->name,
+		       per_sample_x100 / 100, per_sample_x100 % 100, outputs);
+
+		if (bc->cfg.type == RESAMPLE_FIR) {
+			uint32_t from_hz;
+			int db = resample_bench_stopband(&bench_rs, bc->in_hz, &from_hz);
+
+			printk(", stopband %d dB from %u Hz", db, from_hz);
+		}
+
+		printk("\n");
+	}
+}
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef RESAMPLE_BENCH_H_
+#define RESAMPLE_BENCH_H_
+
+/* Print the cost and the stopband attenuation of a set of typical conversions */
+void resample_bench(void);
+
+#endif /* RESAMPLE_BENCH_H_ */
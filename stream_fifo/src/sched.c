@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+
+#include "sched.h"
+
+BUILD_ASSERT(CONFIG_STREAM_FIFO_NUM_SENSORS <= SCHED_MAX_SENSORS);
+BUILD_ASSERT(SCHED_MAX_WORKERS <= 32);
+
+K_MEM_SLAB_DEFINE_STATIC(sched_batch_slab, sizeof(struct imu_batch),
+			 CONFIG_STREAM_FIFO_SCHED_BATCHES, 8);
+
+static K_THREAD_STACK_ARRAY_DEFINE(sched_stacks, SCHED_MAX_WORKERS,
+				   CONFIG_STREAM_FIFO_SCHED_STACK_SIZE);
+
+struct imu_batch *sched_batch_alloc(k_timeout_t timeout)
+{
+	void *batch;
+
+	if (k_mem_slab_alloc(&sched_batch_slab, &batch, timeout) != 0) {
+		return NULL;
+	}
+
+	return batch;
+}
+
+/* Remove and return the oldest batch of @p w whose sensor is not busy */
+static struct imu_batch *sched_take(struct sched *s, struct sched_worker *w)
+{
+	for (uint16_t i = 0; i < w->count; i++) {
+		struct imu_batch *batch = w->queue[i];
+
+		if ((s->busy_sensors & BIT(batch->sensor)) != 0) {
+			continue;
+		}
+
+		memmove(&w->queue[i], &w->queue[i + 1],
+			(w->count - i - 1) * sizeof(w->queue[0]));
+		w->count--;
+		s->busy_sensors |= BIT(batch->sensor);
+
+		return batch;
+	}
+
+	return NULL;
+}
+
+static struct imu_batch *sched_pick(struct sched *s, struct sched_worker *w)
+{
+	k_spinlock_key_t key = k_spin_lock(&s->lock);
+	struct imu_batch *batch = sched_take(s, w);
+
+	for (uint8_t i = 1; batch == NULL && s->stealing && i < s->num_workers; i++) {
+		batch = sched_take(s, &s->workers[(w->id + i) % s->num_workers]);
+		if (batch != NULL) {
+			w->stolen++;
+		}
+	}
+
+	if (batch == NULL) {
+		s->idle_workers |= BIT(w->id);
+	} else {
+		s->idle_workers &= ~BIT(w->id);
+	}
+
+	k_spin_unlock(&s->lock, key);
+
+	return batch;
+}
+
+static void sched_done(struct sched *s, struct sched_worker *w, struct imu_batch *batch)
+{
+	struct sched_worker *home = &s->workers[batch->sensor % s->num_workers];
+	k_spinlock_key_t key = k_spin_lock(&s->lock);
+	bool wake_home, flushed;
+
+	s->busy_sensors &= ~BIT(batch->sensor);
+	w->processed++;
+	flushed = (--s->pending == 0);
+	/* the next batch of this sensor may be waiting on an idle home worker */
+	wake_home = (home != w) && (home->count > 0);
+
+	k_spin_unlock(&s->lock, key);
+
+	k_mem_slab_free(&sched_batch_slab, batch);
+
+	if (wake_home) {
+		k_sem_give(&home->wake);
+	}
+	if (flushed) {
+		k_sem_give(&s->flushed);
+	}
+}
+
+static void sched_worker_thread(void *p1, void *p2, void *p3)
+{
+	struct sched_worker *w = p1;
+	struct sched *s = w->s;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (!s->stop) {
+		struct imu_batch *batch;
+
+		k_sem_take(&w->wake, K_FOREVER);
+
+		while ((batch = sched_pick(s, w)) != NULL) {
+			s->process(batch, s->user_data);
+			sched_done(s, w, batch);
+		}
+	}
+}
+
+int sched_init(struct sched *s, uint8_t num_workers, bool stealing, sched_process_t process,
+	       void *user_data)
+{
+	if (num_workers == 0) {
+		num_workers = arch_num_cpus();
+	}
+
+	if (num_workers > SCHED_MAX_WORKERS) {
+		return -EINVAL;
+	}
+
+	memset(s, 0, sizeof(*s));
+	s->num_workers = num_workers;
+	s->stealing = stealing;
+	s->process = process;
+	s->user_data = user_data;
+	s->idle_workers = BIT_MASK(num_workers);
+	k_sem_init(&s->flushed, 0, 1);
+
+	for (uint8_t i = 0; i < num_workers; i++) {
+		struct sched_worker *w = &s->workers[i];
+		k_tid_t tid;
+
+		w->s = s;
+		w->id = i;
+		k_sem_init(&w->wake, 0, K_SEM_MAX_LIMIT);
+
+		tid = k_thread_create(&w->thread, sched_stacks[i],
+				      K_THREAD_STACK_SIZEOF(sched_stacks[i]),
+				      sched_worker_thread, w, NULL, NULL,
+				      CONFIG_STREAM_FIFO_SCHED_PRIORITY, 0, K_FOREVER);
+		k_thread_name_set(tid, "sched_worker");
+#ifdef CONFIG_STREAM_FIFO_SCHED_PIN
+		k_thread_cpu_pin(tid, i % arch_num_cpus());
+#endif
+		k_thread_start(tid);
+	}
+
+	return 0;
+}
+
+void sched_submit(struct sched *s, struct imu_batch *batch)
+{
+	struct sched_worker *home = &s->workers[batch->sensor % s->num_workers];
+	struct sched_worker *thief = NULL;
+	k_spinlock_key_t key = k_spin_lock(&s->lock);
+
+	/* the pool holds as many batches as a queue, it cannot overflow */
+	home->queue[home->count++] = batch;
+	s->pending++;
+
+	if (s->stealing && (s->idle_workers & BIT(home->id)) == 0 && s->idle_workers != 0) {
+		thief = &s->workers[u32_count_trailing_zeros(s->idle_workers)];
+	}
+
+	k_spin_unlock(&s->lock, key);
+
+	k_sem_give(&home->wake);
+	if (thief != NULL) {
+		k_sem_give(&thief->wake);
+	}
+}
+
+void sched_flush(struct sched *s)
+{
+	k_spinlock_key_t key;
+	bool idle;
+
+	k_sem_reset(&s->flushed);
+
+	key = k_spin_lock(&s->lock);
+	idle = (s->pending == 0);
+	k_spin_unlock(&s->lock, key);
+
+	if (!idle) {
+		k_sem_take(&s->flushed, K_FOREVER);
+	}
+}
+
+void sched_stop(struct sched *s)
+{
+	sched_flush(s);
+
+	s->stop = true;
+	for (uint8_t i = 0; i < s->num_workers; i++) {
+		k_sem_give(&s->workers[i].wake);
+	}
+
+	for (uint8_t i = 0; i < s->num_workers; i++) {
+		k_thread_join(&s->workers[i].thread, K_FOREVER);
+	}
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#include "imu_batch.h"
+
+#define SCHED_MAX_WORKERS	CONFIG_MP_MAX_NUM_CPUS
+
+/* Sensor indexes are tracked in a 32-bit busy mask */
+#define SCHED_MAX_SENSORS	32
+
+typedef void (*sched_process_t)(struct imu_batch *batch, void *user_data);
+
+struct sched;
+
+struct sched_worker {
+	struct sched *s;
+	struct k_thread thread;
+	struct k_sem wake;
+	/* batches waiting for this worker, oldest first */
+	struct imu_batch *queue[CONFIG_STREAM_FIFO_SCHED_BATCHES];
+	uint16_t count;
+	uint8_t id;
+	uint32_t processed;
+	/* batches taken from the queue of another worker */
+	uint32_t stolen;
+};
+
+/*
+ * Distributes decoded batches to one worker thread per CPU.
+ *
+ * All batches of a sensor are queued to the same (home) worker, and a
+ * batch is only handed out while no other batch of the same sensor is
+ * being processed. Since every queue is scanned oldest first, batches of
+ * one sensor are processed one at a time and in submission order, even
+ * when an idle worker steals them from the home queue.
+ */
+struct sched {
+	struct k_spinlock lock;
+	struct sched_worker workers[SCHED_MAX_WORKERS];
+	uint8_t num_workers;
+	bool stealing;
+	bool stop;
+	/* bit n set while a batch of sensor n is being processed */
+	uint32_t busy_sensors;
+	/* bit n set while worker n waits for work */
+	uint32_t idle_workers;
+	/* batches submitted and not processed yet */
+	uint32_t pending;
+	struct k_sem flushed;
+	sched_process_t process;
+	void *user_data;
+};
+
+/**
+ * @brief Start the workers.
+ *
+ * @param num_workers Number of worker threads, 0 for one per CPU
+ * @param stealing Let idle workers take batches queued to busy ones
+ * @param process Called on a worker thread for every batch
+ * @return 0 on success, -EINVAL if too many workers are requested
+ */
+int sched_init(struct sched *s, uint8_t num_workers, bool stealing, sched_process_t process,
+	       void *user_data);
+
+/* Get a free batch from the shared pool, the worker returns it after processing */
+struct imu_batch *sched_batch_alloc(k_timeout_t timeout);
+
+/* Queue a batch allocated with sched_batch_alloc() to the home worker of its sensor */
+void sched_submit(struct sched *s, struct imu_batch *batch);
+
+/* Wait until all submitted batches are processed */
+void sched_flush(struct sched *s);
+
+/* Flush, then stop and join the workers */
+void sched_stop(struct sched *s);
+
+/* Print the processing scaling for 1 to the number of CPUs workers */
+void sched_bench(void);
+
+#endif /* SCHED_H_ */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include "sched.h"
+
+#define BENCH_SENSORS	CONFIG_STREAM_FIFO_SCHED_BENCH_SENSORS
+#define BENCH_FRAMES	MIN(64, CONFIG_STREAM_FIFO_BATCH_SAMPLES)
+
+BUILD_ASSERT(BENCH_SENSORS <= SCHED_MAX_SENSORS);
+
+static struct sched bench_sched;
+static uint64_t bench_expected[BENCH_SENSORS];
+static atomic_t bench_order_errors;
+static volatile uint32_t bench_sink;
+
+/*
+ * Synthetic per-frame load standing in for the processing stages. The
+ * batch sequence number travels in arrival_ns and is checked against the
+ * previous batch of the same sensor.
+ */
+static void bench_process(struct imu_batch *batch, void *user_data)
+{
+	const struct imu_sample *xl = imu_batch_samples_const(batch, IMU_CHAN_XL);
+	uint32_t acc = 0;
+
+	ARG_UNUSED(user_data);
+
+	if (batch->arrival_ns != bench_expected[batch->sensor]) {
+		atomic_inc(&bench_order_errors);
+	}
+	bench_expected[batch->sensor] = batch->arrival_ns + 1;
+
+	for (uint16_t k = 0; k < batch->chan[IMU_CHAN_XL].count; k++) {
+		for (int i = 0; i < CONFIG_STREAM_FIFO_SCHED_BENCH_WORK; i++) {
+			acc = acc * 1664525U + (uint32_t)xl[k].v[i % 3];
+		}
+	}
+
+	bench_sink = acc;
+}
+
+static void bench_fill(struct imu_batch *batch, uint8_t sensor, uint64_t seq)
+{
+	const uint16_t counts[IMU_CHAN_COUNT] = { [IMU_CHAN_XL] = BENCH_FRAMES };
+	struct imu_sample *xl;
+
+	imu_batch_reset(batch, sensor, seq, counts);
+	xl = imu_batch_samples(batch, IMU_CHAN_XL);
+
+	for (uint16_t k = 0; k < BENCH_FRAMES; k++) {
+		xl[k].timestamp_ns = seq * BENCH_FRAMES + k;
+		xl[k].v[0] = (int32_t)(k * 0x01000193U);
+		xl[k].v[1] = (int32_t)(seq * 0x9e3779b9U);
+		xl[k].v[2] = sensor;
+	}
+	batch->chan[IMU_CHAN_XL].count = BENCH_FRAMES;
+}
+
+/* Run the benchmark load and return the elapsed time in microseconds */
+static uint64_t bench_run(uint8_t workers, bool stealing)
+{
+	uint64_t seq[BENCH_SENSORS] = { 0 };
+	int64_t start;
+
+	memset(bench_expected, 0, sizeof(bench_expected));
+	atomic_clear(&bench_order_errors);
+
+	sched_init(&bench_sched, workers, stealing, bench_process, NULL);
+
+	start = k_uptime_ticks();
+
+	for (int i = 0; i < CONFIG_STREAM_FIFO_SCHED_BENCH_BATCHES; i++) {
+		uint8_t sensor = i % BENCH_SENSORS;
+		struct imu_batch *batch = sched_batch_alloc(K_FOREVER);
+
+		bench_fill(batch, sensor, seq[sensor]++);
+		sched_submit(&bench_sched, batch);
+	}
+
+	sched_flush(&bench_sched);
+
+	uint64_t elapsed_us = k_ticks_to_us_floor64(k_uptime_ticks() - start);
+
+	sched_stop(&bench_sched);
+
+	return MAX(elapsed_us, 1);
+}
+
+void sched_bench(void)
+{
+	uint64_t base_us = 0;
+
+	printk("sched bench: %u CPUs, %u sensors, %u batches of %u frames\n",
+	       arch_num_cpus(), BENCH_SENSORS, CONFIG_STREAM_FIFO_SCHED_BENCH_BATCHES,
+	       BENCH_FRAMES);
+
+	for (int stealing = 0; stealing <= 1; stealing++) {
+		for (uint8_t workers = 1; workers <= arch_num_cpus(); workers++) {
+			uint64_t us = bench_run(workers, stealing);
+			uint32_t stolen = 0;
+
+			if (base_us == 0) {
+				base_us = us;
+			}
+
+			for (uint8_t i = 0; i < workers; i++) {
+				stolen += bench_sched.workers[i].stolen;
+			}
+
+			uint32_t speedup_x100 = (base_us * 100) / us;
+
+			printk("sched bench: %u workers, stealing %s: %llu us, %llu batches/s, "
+			       "speedup %u.%02u, %u stolen, %ld order errors\n",
+			       workers, stealing ? "on" : "off", us,
+			       (uint64_t)CONFIG_STREAM_FIFO_SCHED_BENCH_BATCHES * USEC_PER_SEC / us,
+			       speedup_x100 / 100, speedup_x100 % 100, stolen,
+			       atomic_get(&bench_order_errors));
+		}
+	}
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "shed.h"
+
+static const char *const shed_reason_name[] = {
+	[SHED_BACKLOG] = "backlog",
+	[SHED_OVERRUN] = "overrun",
+	[SHED_RESTORE] = "restore",
+};
+
+void shed_init(struct shed *s, const uint8_t prio[IMU_CHAN_COUNT], uint8_t max_decim,
+	       uint32_t hold_ms, uint32_t restore_ms, uint64_t now_ns)
+{
+	uint8_t top = 0;
+	uint8_t dropped = 0;
+
+	memset(s, 0, sizeof(*s));
+	s->hold_ms = hold_ms;
+	s->restore_ms = restore_ms;
+	s->level_since_ns = now_ns;
+	s->kept_up_since_ns = now_ns;
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		top = MAX(top, prio[i]);
+	}
+
+	s->levels[0].decim = 1;
+	s->num_levels = 1;
+
+	/* one step per priority below the highest, lowest first */
+	while (true) {
+		int next = -1;
+
+		for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+			if (!(dropped & BIT(i)) && prio[i] < top && (next < 0 || prio[i] < next)) {
+				next = prio[i];
+			}
+		}
+
+		if (next < 0) {
+			break;
+		}
+
+		for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+			if (prio[i] == next) {
+				dropped |= BIT(i);
+			}
+		}
+
+		s->levels[s->num_levels].drop_mask = dropped;
+		s->levels[s->num_levels].decim = 1;
+		s->num_levels++;
+	}
+
+	for (uint16_t decim = 2; decim <= max_decim && s->num_levels < SHED_MAX_LEVELS;
+	     decim *= 2) {
+		s->levels[s->num_levels].drop_mask = dropped;
+		s->levels[s->num_levels].decim = decim;
+		s->num_levels++;
+	}
+}
+
+static const struct shed_action *shed_set(struct shed *s, uint64_t now_ns, uint8_t to,
+					  enum shed_reason reason)
+{
+	struct shed_action *a = &s->log[(s->log_head + s->log_count) % SHED_LOG_SIZE];
+
+	if (s->log_count == SHED_LOG_SIZE) {
+		s->log_head = (s->log_head + 1) % SHED_LOG_SIZE;
+	} else {
+		s->log_count++;
+	}
+
+	a->time_ns = now_ns;
+	a->duration_ms = (now_ns - s->level_since_ns) / NSEC_PER_MSEC;
+	a->from = s->level;
+	a->to = to;
+	a->reason = reason;
+
+	if (s->level == 0) {
+		memset(&s->episode, 0, sizeof(s->episode));
+		s->episode.start_ns = now_ns;
+	}
+
+	s->episode.actions++;
+	s->episode.level_ms[s->level] += a->duration_ms;
+	s->episode.max_level = MAX(s->episode.max_level, to);
+
+	s->level = to;
+	s->level_since_ns = now_ns;
+	/* the new factor starts on the next frame of every channel */
+	memset(s->phase, 0, sizeof(s->phase));
+
+	return a;
+}
+
+const struct shed_action *shed_update(struct shed *s, uint64_t now_ns, bool behind,
+				      bool overrun)
+{
+	uint64_t at_level_ns = now_ns - s->level_since_ns;
+	uint64_t hold_ns = (uint64_t)s->hold_ms * NSEC_PER_MSEC;
+	uint64_t restore_ns = (uint64_t)s->restore_ms * NSEC_PER_MSEC;
+
+	if (behind || overrun) {
+		if (!s->behind) {
+			s->behind = true;
+			s->behind_since_ns = now_ns;
+		}
+	} else if (s->behind) {
+		s->behind = false;
+		s->kept_up_since_ns = now_ns;
+	}
+
+	/* give every level the hold time to take effect */
+	if (s->level + 1 < s->num_levels && at_level_ns >= hold_ns) {
+		if (overrun) {
+			return shed_set(s, now_ns, s->level + 1, SHED_OVERRUN);
+		}
+		if (s->behind && now_ns - s->behind_since_ns >= hold_ns) {
+			return shed_set(s, now_ns, s->level + 1, SHED_BACKLOG);
+		}
+	}
+
+	if (s->level > 0 && !s->behind && at_level_ns >= restore_ns &&
+	    now_ns - s->kept_up_since_ns >= restore_ns) {
+		return shed_set(s, now_ns, s->level - 1, SHED_RESTORE);
+	}
+
+	return NULL;
+}
+
+uint16_t shed_filter_counts(struct shed *s, uint16_t counts[IMU_CHAN_COUNT])
+{
+	uint8_t mask = s->levels[s->level].drop_mask;
+	uint16_t removed = 0;
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		if (mask & BIT(i)) {
+			removed += counts[i];
+			counts[i] = 0;
+		}
+	}
+
+	s->frames_shed += removed;
+	s->episode.frames_shed += removed;
+
+	return removed;
+}
+
+void shed_mark_decimation(struct shed *s, struct imu_batch *b)
+{
+	uint8_t decim = s->levels[s->level].decim;
+
+	b->decim = decim;
+	if (decim <= 1) {
+		return;
+	}
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		uint8_t *phase = &s->phase[b->sensor][i];
+		uint16_t count = b->chan[i].count;
+		/* frames at phase 0 are kept, the first one at index first */
+		uint16_t first = (decim - *phase) % decim;
+		uint16_t kept = (first < count) ? (count - 1 - first) / decim + 1 : 0;
+
+		b->phase[i] = *phase;
+		*phase = (*phase + count) % decim;
+
+		s->frames_shed += count - kept;
+		s->episode.frames_shed += count - kept;
+	}
+}
+
+void shed_decimate(struct imu_batch *b)
+{
+	if (b->decim <= 1) {
+		return;
+	}
+
+	for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+		struct imu_sample *smp = imu_batch_samples(b, i);
+		uint8_t phase = b->phase[i];
+		uint16_t count = b->chan[i].count;
+		uint16_t kept = 0;
+
+		for (uint16_t k = 0; k < count; k++) {
+			if (phase == 0) {
+				smp[kept++] = smp[k];
+			}
+			phase = (phase + 1) % b->decim;
+		}
+
+		b->chan[i].count = kept;
+	}
+}
+
+/* The actions of the log that belong to the current episode, oldest first */
+static void shed_print_log(const struct shed *s)
+{
+	const struct shed_episode *e = &s->episode;
+	uint16_t count = MIN(s->log_count, e->actions);
+
+	printk("shed: last %u actions of %u:\n", count, e->actions);
+
+	for (uint16_t i = s->log_count - count; i < s->log_count; i++) {
+		const struct shed_action *a = &s->log[(s->log_head + i) % SHED_LOG_SIZE];
+
+		printk("shed:   +%llu ms level %u -> %u (%s) after %u ms\n",
+		       (a->time_ns - e->start_ns) / NSEC_PER_MSEC, a->from, a->to,
+		       shed_reason_name[a->reason], a->duration_ms);
+	}
+}
+
+void shed_print(const struct shed *s, const struct shed_action *a)
+{
+	const struct shed_level *l = &s->levels[a->to];
+	const struct shed_episode *e = &s->episode;
+
+	printk("shed: level %u -> %u (%s) after %u ms at level %u: ", a->from, a->to,
+	       shed_reason_name[a->reason], a->duration_ms, a->from);
+
+	if (a->to == 0) {
+		printk("full service\n");
+		printk("shed: full service restored after %llu ms, %u actions, max level %u, "
+		       "%u frames shed, ms per level:", (a->time_ns - e->start_ns) / NSEC_PER_MSEC,
+		       e->actions, e->max_level, e->frames_shed);
+		for (uint8_t i = 1; i <= e->max_level; i++) {
+			printk(" %u", e->level_ms[i]);
+		}
+		printk("\n");
+		shed_print_log(s);
+		return;
+	}
+
+	if (l->drop_mask != 0) {
+		const char *sep = "drop ";
+
+		for (int i = 0; i < IMU_CHAN_COUNT; i++) {
+			if (l->drop_mask & BIT(i)) {
+				printk("%s%s", sep, imu_chan_name[i]);
+				sep = ",";
+			}
+		}
+	}
+
+	if (l->decim > 1) {
+		printk("%sdecimate %u", (l->drop_mask != 0) ? ", " : "", l->decim);
+	}
+
+	printk("\n");
+}
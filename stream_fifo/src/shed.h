@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SHED_H_
+#define SHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu_batch.h"
+
+#define SHED_MAX_DECIM_STEPS	4
+/* full service, one drop step per priority but the highest, the decimations */
+#define SHED_MAX_LEVELS		(IMU_CHAN_COUNT + SHED_MAX_DECIM_STEPS)
+#define SHED_LOG_SIZE		CONFIG_STREAM_FIFO_SHED_LOG_SIZE
+#define SHED_SENSORS		CONFIG_STREAM_FIFO_NUM_SENSORS
+
+enum shed_reason {
+	SHED_BACKLOG,
+	SHED_OVERRUN,
+	SHED_RESTORE,
+};
+
+/* What is left of the stream at one level */
+struct shed_level {
+	/* BIT(chan) of every channel neither decoded nor processed */
+	uint8_t drop_mask;
+	/* one frame out of decim is kept in the other channels */
+	uint8_t decim;
+};
+
+/* One level change, with the time spent at the level it left */
+struct shed_action {
+	uint64_t time_ns;
+	uint32_t duration_ms;
+	uint8_t from;
+	uint8_t to;
+	enum shed_reason reason;
+};
+
+/* From the first shed action to the return to full service */
+struct shed_episode {
+	uint64_t start_ns;
+	uint32_t actions;
+	uint32_t frames_shed;
+	uint8_t max_level;
+	uint32_t level_ms[SHED_MAX_LEVELS];
+};
+
+/*
+ * Overload policy: the levels go from full service (0) to dropping the
+ * channels of lowest priority first, one priority at a time, and then to
+ * decimating the channels left by 2, 4, ... The level goes up by one once
+ * the consumer has been behind the sensors for the hold time, and comes
+ * back down by one once it has kept up for the restore time.
+ *
+ * Not thread safe: all calls must come from the acquisition thread.
+ */
+struct shed {
+	struct shed_level levels[SHED_MAX_LEVELS];
+	uint8_t num_levels;
+	uint8_t level;
+	uint64_t level_since_ns;
+	uint32_t hold_ms;
+	uint32_t restore_ms;
+	/* state of the backlog signal and since when */
+	bool behind;
+	uint64_t behind_since_ns;
+	uint64_t kept_up_since_ns;
+	struct shed_episode episode;
+	/* latest actions, oldest first from log_head */
+	struct shed_action log[SHED_LOG_SIZE];
+	uint16_t log_head;
+	uint16_t log_count;
+	uint32_t frames_shed;
+	/* decimation phase of each sensor and channel, across drains */
+	uint8_t phase[SHED_SENSORS][IMU_CHAN_COUNT];
+};
+
+/**
+ * @brief Build the levels of a policy.
+ *
+ * The channels of the highest priority are never dropped.
+ *
+ * @param s Policy
+ * @param prio Priority of each channel, the lowest is dropped first
+ * @param max_decim Largest decimation factor, rounded down to a power of two
+ * @param hold_ms Time behind the sensors before the next level
+ * @param restore_ms Time keeping up before the previous level
+ * @param now_ns Current uptime
+ */
+void shed_init(struct shed *s, const uint8_t prio[IMU_CHAN_COUNT], uint8_t max_decim,
+	       uint32_t hold_ms, uint32_t restore_ms, uint64_t now_ns);
+
+/**
+ * @brief Feed the backlog observed at one FIFO drain.
+ *
+ * An overrun raises the level right away, at most once per hold time:
+ * frames are already lost.
+ *
+ * @param s Policy
+ * @param now_ns Arrival time of the drain
+ * @param behind More drains were waiting than the sensors deliver at once
+ * @param overrun The sensor FIFO overflowed before this drain
+ * @return Action taken, NULL if the level did not change
+ */
+const struct shed_action *shed_update(struct shed *s, uint64_t now_ns, bool behind,
+				      bool overrun);
+
+/**
+ * @brief Clear the frame counts of the channels dropped at the current level.
+ *
+ * @return Frames removed
+ */
+uint16_t shed_filter_counts(struct shed *s, uint16_t counts[IMU_CHAN_COUNT]);
+
+/**
+ * @brief Mark a batch for decimation at the current level.
+ *
+ * Counts the frames shed_decimate() will remove. The phase is kept per
+ * sensor and channel, so frames stay evenly spaced across drains.
+ */
+void shed_mark_decimation(struct shed *s, struct imu_batch *b);
+
+/**
+ * @brief Decimate the channels of a batch in place as marked.
+ *
+ * Only touches the batch, so it can run on the processing threads, after
+ * the stages that need the sensor rate.
+ */
+void shed_decimate(struct imu_batch *b);
+
+/**
+ * @brief Print an action.
+ *
+ * When it restores full service, also print the episode summary and the
+ * actions of the episode still in the log.
+ */
+void shed_print(const struct shed *s, const struct shed_action *a);
+
+#endif /* SHED_H_ */
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "timeline.h"
+
+#define HORIZON_NS ((uint64_t)CONFIG_STREAM_FIFO_TIMELINE_HORIZON_MS * NSEC_PER_MSEC)
+
+void timeline_init(struct timeline *tl, uint8_t num_sensors, timeline_emit_t emit,
+		   void *user_data)
+{
+	*tl = (struct timeline){ 0 };
+	tl->num_sensors = MIN(num_sensors, ARRAY_SIZE(tl->queues));
+	tl->emit = emit;
+	tl->user_data = user_data;
+}
+
+static struct timeline_frame *timeline_head(struct timeline *tl, uint8_t sensor)
+{
+	struct timeline_queue *q = &tl->queues[sensor];
+
+	return (q->count > 0) ? &q->frames[q->head] : NULL;
+}
+
+/* Queue with the oldest head frame, -1 if all queues are empty */
+static int timeline_oldest(struct timeline *tl)
+{
+	int oldest = -1;
+
+	for (uint8_t i = 0; i < tl->num_sensors; i++) {
+		struct timeline_frame *f = timeline_head(tl, i);
+
+		if (f != NULL && (oldest < 0 || f->sample.timestamp_ns <
+				  timeline_head(tl, oldest)->sample.timestamp_ns)) {
+			oldest = i;
+		}
+	}
+
+	return oldest;
+}
+
+static void timeline_pop(struct timeline *tl, uint8_t sensor)
+{
+	struct timeline_queue *q = &tl->queues[sensor];
+	struct timeline_frame *f = &q->frames[q->head];
+
+	if (tl->emitted > 0 && f->sample.timestamp_ns < tl->last_ns) {
+		tl->out_of_order++;
+	}
+
+	tl->last_ns = MAX(tl->last_ns, f->sample.timestamp_ns);
+	tl->emitted++;
+
+	if (tl->emit != NULL) {
+		tl->emit(f, tl->user_data);
+	}
+
+	q->head = (q->head + 1) % ARRAY_SIZE(q->frames);
+	q->count--;
+}
+
+void timeline_push(struct timeline *tl, const struct imu_batch *batch)
+{
+	struct timeline_queue *q;
+	uint16_t next[IMU_CHAN_COUNT] = { 0 };
+
+	if (batch->sensor >= tl->num_sensors) {
+		return;
+	}
+
+	q = &tl->queues[batch->sensor];
+
+	/* every channel is time ordered, merge them into the sensor queue */
+	while (true) {
+		const struct imu_sample *s = NULL;
+		int chan = -1;
+
+		for (int c = 0; c < IMU_CHAN_COUNT; c++) {
+			const struct imu_sample *cand;
+
+			if (next[c] >= batch->chan[c].count) {
+				continue;
+			}
+
+			cand = &imu_batch_samples_const(batch, c)[next[c]];
+			if (s == NULL || cand->timestamp_ns < s->timestamp_ns) {
+				s = cand;
+				chan = c;
+			}
+		}
+
+		if (s == NULL) {
+			break;
+		}
+
+		if (q->count == ARRAY_SIZE(q->frames)) {
+			/* make room by releasing the globally oldest frame */
+			tl->overflows++;
+			timeline_pop(tl, timeline_oldest(tl));
+		}
+
+		struct timeline_frame *f =
+			&q->frames[(q->head + q->count) % ARRAY_SIZE(q->frames)];
+
+		f->sample = *s;
+		f->sensor = batch->sensor;
+		f->chan = chan;
+		f->shift = batch->chan[chan].shift;
+		q->count++;
+		next[chan]++;
+	}
+}
+
+void timeline_release(struct timeline *tl, uint64_t now_ns)
+{
+	while (true) {
+		int oldest = timeline_oldest(tl);
+		bool all_ready = true;
+
+		if (oldest < 0) {
+			return;
+		}
+
+		for (uint8_t i = 0; i < tl->num_sensors; i++) {
+			if (tl->queues[i].count == 0) {
+				all_ready = false;
+				break;
+			}
+		}
+
+		if (!all_ready &&
+		    timeline_head(tl, oldest)->sample.timestamp_ns + HORIZON_NS > now_ns) {
+			return;
+		}
+
+		timeline_pop(tl, oldest);
+	}
+}
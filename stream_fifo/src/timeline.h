@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TIMELINE_H_
+#define TIMELINE_H_
+
+#include <stdint.h>
+
+#include "imu_batch.h"
+
+struct timeline_frame {
+	struct imu_sample sample;
+	uint8_t sensor;
+	uint8_t chan;
+	int8_t shift;
+};
+
+typedef void (*timeline_emit_t)(const struct timeline_frame *frame, void *user_data);
+
+struct timeline_queue {
+	struct timeline_frame frames[CONFIG_STREAM_FIFO_TIMELINE_DEPTH];
+	uint16_t head;
+	uint16_t count;
+};
+
+/*
+ * Merges the aligned frames of several sensors into one time-ordered
+ * stream. A frame is released once every sensor has delivered a frame at
+ * least as recent, or once it is older than the configured horizon.
+ */
+struct timeline {
+	struct timeline_queue queues[CONFIG_STREAM_FIFO_NUM_SENSORS];
+	uint8_t num_sensors;
+	uint64_t last_ns;
+	uint32_t emitted;
+	/* frames released after a more recent one (late sensor or overflow) */
+	uint32_t out_of_order;
+	/* frames released early because a sensor queue was full */
+	uint32_t overflows;
+	timeline_emit_t emit;
+	void *user_data;
+};
+
+void timeline_init(struct timeline *tl, uint8_t num_sensors, timeline_emit_t emit,
+		   void *user_data);
+
+/* Queue the frames of a batch whose timestamps are already in system uptime */
+void timeline_push(struct timeline *tl, const struct imu_batch *batch);
+
+/* Release all frames that can no longer be preceded by another sensor */
+void timeline_release(struct timeline *tl, uint64_t now_ns);
+
+#endif /* TIMELINE_H_ */
@@ -13,6 +13,84 @@
 #include <zephyr/sys/util.h>
 #include "common_utils.h"
 #include "otd.h"
+#include "resample.h"
+
+/* OTD runs at 50 Hz, the accelerometer is sampled at 100 Hz */
+#define XL_ODR_HZ	100
+#define OTD_ODR_HZ	50
+
+/* fractional bits kept on the mg values while resampling */
+#define OTD_MG_SHIFT	8
+
+/* Startup milestones, reported once the first window is classified */
+enum boot_mark {
+	BOOT_MAIN,
+	BOOT_SENSOR_CONFIG,
+	BOOT_OTD_READY,
+	BOOT_FIRST_DRDY,
+	BOOT_FIRST_SAMPLE,
+	BOOT_FIRST_DECISION,
+	BOOT_MARKS,
+};
+
+static const char *const boot_mark_name[] = {
+	[BOOT_MAIN] = "main",
+	[BOOT_SENSOR_CONFIG] = "sensor configured",
+	[BOOT_OTD_READY] = "otd ready",
+	[BOOT_FIRST_DRDY] = "first data ready",
+	[BOOT_FIRST_SAMPLE] = "first sample",
+	[BOOT_FIRST_DECISION] = "first decision",
+};
+
+static uint64_t boot_us[BOOT_MARKS];
+/* the data ready mark is set from the trigger thread */
+static atomic_t boot_marked;
+
+/* Record the uptime of @p mark the first time it is reached */
+static void boot_mark(enum boot_mark mark)
+{
+	if (atomic_test_bit(&boot_marked, mark)) {
+		return;
+	}
+
+	boot_us[mark] = k_ticks_to_us_floor64(k_uptime_ticks());
+	atomic_set_bit(&boot_marked, mark);
+}
+
+/* Print the marks reached in time order: with the fast boot the sensor runs before OTD */
+static void boot_report(void)
+{
+	uint8_t order[BOOT_MARKS];
+	uint8_t n = 0;
+	uint64_t prev_us = 0;
+
+	for (uint8_t i = 0; i < BOOT_MARKS; i++) {
+		uint8_t k;
+
+		if (!atomic_test_bit(&boot_marked, i)) {
+			continue;
+		}
+
+		/* insertion by uptime */
+		for (k = n; k > 0 && boot_us[order[k - 1]] > boot_us[i]; k--) {
+			order[k] = order[k - 1];
+		}
+		order[k] = i;
+		n++;
+	}
+
+	printk("boot timing:");
+	for (uint8_t k = 0; k < n; k++) {
+		uint8_t i = order[k];
+
+		printk("%s %s %llu.%03llu ms (+%llu.%03llu)", (k == 0) ? "" : ",",
+		       boot_mark_name[i], boot_us[i] / USEC_PER_MSEC, boot_us[i] % USEC_PER_MSEC,
+		       (boot_us[i] - prev_us) / USEC_PER_MSEC,
+		       (boot_us[i] - prev_us) % USEC_PER_MSEC);
+		prev_us = boot_us[i];
+	}
+	printk("\n");
+}
 
 #ifdef CONFIG_LIS2DUX12_TRIGGER
 static struct k_sem lis2dux12_acc_drdy;
@@ -21,6 +99,7 @@ static int lis2dux12_acc_trig_cnt;
 static void lis2dux12_acc_trig_handler(const struct device *dev,
 				       const struct sensor_trigger *trig)
 {
+	boot_mark(BOOT_FIRST_DRDY);
 	lis2dux12_acc_trig_cnt++;
 	k_sem_give(&lis2dux12_acc_drdy);
 }
@@ -31,7 +110,7 @@ static void lis2dux12_config(const struct device *lis2dux12)
 	struct sensor_value odr_attr, fs_attr;
 
 	/* set LSM6DSV16X accel sampling frequency to 408 Hz */
-	odr_attr.val1 = 100;
+	odr_attr.val1 = XL_ODR_HZ;
 	odr_attr.val2 = 0;
 
 	if (sensor_attr_set(lis2dux12, SENSOR_CHAN_ACCEL_XYZ,
@@ -61,10 +140,11 @@ static const struct gpio_dt_spec green_gpio = GPIO_DT_SPEC_GET(DT_ALIAS(led0), g
 static const struct gpio_dt_spec blue_gpio = GPIO_DT_SPEC_GET(DT_ALIAS(led1), gpios);
 static const struct gpio_dt_spec red_gpio = GPIO_DT_SPEC_GET(DT_ALIAS(led2), gpios);
 
-static int led_pattern(void)
-{
-	int i;
+#define LED_PATTERN_STEPS	9
+#define LED_PATTERN_STEP_MS	200
 
+static int led_init(void)
+{
 	/* led 0 */
 	if (!gpio_is_ready_dt(&green_gpio)) {
 		printk("%s: device not ready.\n", green_gpio.port->name);
@@ -86,22 +166,79 @@ static int led_pattern(void)
 	}
 	gpio_pin_configure_dt(&red_gpio, GPIO_OUTPUT_INACTIVE);
 
-	/* output led alternate pattern */
-	for (i = 0; i < 9; i++) {
-		gpio_pin_set_dt(&green_gpio, ((i % 3) == 0) ? 1 : 0);
-		gpio_pin_set_dt(&blue_gpio, ((i % 3) == 1) ? 1 : 0);
-		gpio_pin_set_dt(&red_gpio, ((i % 3) == 2) ? 1 : 0);
-		k_msleep(200);
+	return 0;
+}
+
+/* output led alternate pattern, then turn all leds off but blue */
+static void led_pattern_step(int i)
+{
+	bool done = (i == LED_PATTERN_STEPS);
+
+	gpio_pin_set_dt(&green_gpio, (!done && (i % 3) == 0) ? 1 : 0);
+	gpio_pin_set_dt(&blue_gpio, (done || (i % 3) == 1) ? 1 : 0);
+	gpio_pin_set_dt(&red_gpio, (!done && (i % 3) == 2) ? 1 : 0);
+}
+
+static int led_pattern(void)
+{
+	int rc = led_init();
+
+	if (rc != 0) {
+		return rc;
 	}
 
-	/* turn all leds off but blue */
-	gpio_pin_set_dt(&green_gpio, 0);
-	gpio_pin_set_dt(&blue_gpio, 1);
-	gpio_pin_set_dt(&red_gpio, 0);
+	for (int i = 0; i < LED_PATTERN_STEPS; i++) {
+		led_pattern_step(i);
+		k_msleep(LED_PATTERN_STEP_MS);
+	}
+	led_pattern_step(LED_PATTERN_STEPS);
 
 	return 0;
 }
 
+#ifdef CONFIG_OTD_FAST_BOOT
+static int led_pattern_pos;
+
+static void led_pattern_work_handler(struct k_work *work)
+{
+	led_pattern_step(led_pattern_pos);
+
+	if (led_pattern_pos++ < LED_PATTERN_STEPS) {
+		k_work_reschedule(k_work_delayable_from_work(work), K_MSEC(LED_PATTERN_STEP_MS));
+	}
+}
+
+static K_WORK_DELAYABLE_DEFINE(led_pattern_work, led_pattern_work_handler);
+
+/* Same pattern as led_pattern(), played from the system workqueue */
+static int led_pattern_start(void)
+{
+	int rc = led_init();
+
+	if (rc != 0) {
+		return rc;
+	}
+
+	led_pattern_pos = 0;
+	k_work_schedule(&led_pattern_work, K_NO_WAIT);
+
+	return 0;
+}
+#endif /* CONFIG_OTD_FAST_BOOT */
+
+static void otd_print_versions(void)
+{
+	char common_utils_ver[12];
+	char otd_ver[12];
+
+	// Get Utils library version
+	common_utils_get_version(common_utils_ver, 12);
+	printf("[LIB] Common utils library version: %s\n", common_utils_ver);
+
+	otd_get_version(otd_ver, 12);
+	printf("[LIB] On-Table Detection version: %s\n", otd_ver);
+}
+
 int main(void)
 {
 	struct sensor_value lis2dux12_xl[3];
@@ -111,7 +248,12 @@ int main(void)
 #endif
 	const struct device *const lis2dux12 = DEVICE_DT_GET_ONE(st_lis2dux12);
 
-	led_pattern();
+	boot_mark(BOOT_MAIN);
+
+	/* the fast boot plays the pattern once the sensor is sampling */
+	if (!IS_ENABLED(CONFIG_OTD_FAST_BOOT)) {
+		led_pattern();
+	}
 
 #ifdef CONFIG_LIS2DUX12_TRIGGER
 	k_sem_init(&lis2dux12_acc_drdy, 0, K_SEM_MAX_LIMIT);
@@ -124,21 +266,27 @@ int main(void)
 	printk("%s: device is ready\n", lis2dux12->name);
 
 	lis2dux12_config(lis2dux12);
+	boot_mark(BOOT_SENSOR_CONFIG);
 
-	// Get Utils library version
-	char common_utils_ver[12];
-
-	common_utils_get_version(common_utils_ver, 12);
-	printf("[LIB] Common utils library version: %s\n", common_utils_ver);
+#ifdef CONFIG_OTD_FAST_BOOT
+	/* OTD is initialized while the sensor takes its first samples */
+	led_pattern_start();
+#else
+	otd_print_versions();
+#endif
 
 	// Initialize On-Table Detection library
 	otd_init_status_t otd_init_status;
 	otd_state_t *otd_state;
-	uint8_t otd_decimator;
-
-	char otd_ver[12];
-	otd_get_version(otd_ver, 12);
-	printf("[LIB] On-Table Detection version: %s\n", otd_ver);
+	/* about 1 KB with the tap limits, too much for the main stack */
+	static struct resample otd_resample;
+	struct resample_config otd_resample_cfg = {
+		.type = RESAMPLE_FIR,
+		.span = 16,
+		.cutoff_pct = 90,
+		.channels = 3,
+	};
+	struct imu_sample xl_sample, otd_sample;
 
 	otd_state = otd_get_instance(0);
 	if (otd_state == NULL)
@@ -161,7 +309,14 @@ int main(void)
 		printf("[LIB] On-Table Detection init failed with error %d\n", otd_init_status);
 		return -1;
 	}
-	otd_decimator = 4;
+
+	resample_ratio(XL_ODR_HZ, OTD_ODR_HZ, &otd_resample_cfg.up, &otd_resample_cfg.down);
+	if (resample_init(&otd_resample, &otd_resample_cfg) != 0)
+	{
+		printf("[LIB] On-Table Detection resampler init failed\n");
+		return -1;
+	}
+	boot_mark(BOOT_OTD_READY);
 
 	while (1) {
 		//gpio_pin_toggle_dt(&green_gpio);
@@ -180,19 +335,35 @@ int main(void)
 
 		/* Get sensor data */
 		sensor_channel_get(lis2dux12, SENSOR_CHAN_ACCEL_XYZ, lis2dux12_xl);
+		boot_mark(BOOT_FIRST_SAMPLE);
 
 		otd_output_t otd_out_raw;
 		otd_output_t otd_out_meta;
 		otd_input_t otd_in;
 
+		xl_sample.timestamp_ns = k_ticks_to_ns_floor64(k_uptime_ticks());
 		for (uint8_t i = 0; i < 3; i++) {
 			acc_data[i] = sensor_ms2_to_mg(&lis2dux12_xl[i]);
-			otd_in.acc[i] = acc_data[i];
+			xl_sample.v[i] = (int32_t)acc_data[i] << OTD_MG_SHIFT;
 		}
 
-		if (otd_run(otd_state, &otd_out_raw, &otd_out_meta, &otd_in))
-		{
-			printf("[LIB] Current On-Table Detection output:\t%d\n", otd_out_meta);
+		/* low-pass and decimate to the OTD rate, run once per output */
+		if (resample_process(&otd_resample, &xl_sample, 1, &otd_sample, 1) > 0) {
+			for (uint8_t i = 0; i < 3; i++) {
+				otd_in.acc[i] = (float)otd_sample.v[i] / (1 << OTD_MG_SHIFT);
+			}
+
+			if (otd_run(otd_state, &otd_out_raw, &otd_out_meta, &otd_in))
+			{
+				if (!atomic_test_bit(&boot_marked, BOOT_FIRST_DECISION)) {
+					boot_mark(BOOT_FIRST_DECISION);
+					boot_report();
+					if (IS_ENABLED(CONFIG_OTD_FAST_BOOT)) {
+						otd_print_versions();
+					}
+				}
+				printf("[LIB] Current On-Table Detection output:\t%d\n", otd_out_meta);
+			}
 		}
 
 #ifdef CONFIG_PRINT_ACCEL_DATA
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#ifdef CONFIG_RISCV
+#include <zephyr/arch/riscv/csr.h>
+#endif
+
+#include "otd.h"
+
+/* otd_run() must be called at 50 Hz */
+#define OTD_ODR_HZ	50
+#define PROF_SAMPLES	(CONFIG_OTD_PROF_SECONDS * OTD_ODR_HZ)
+#define PROF_2PI	6.2831853f
+
+#ifdef OTD_PROF_TRACE
+/* int16 x, y, z in mg, little endian */
+static const uint8_t otd_trace[] = {
+#include "otd_trace.inc"
+};
+#endif
+
+enum prof_input {
+	PROF_TABLE,
+	PROF_LAP,
+	PROF_MOTION,
+	PROF_TRACE,
+};
+
+static const char *const prof_input_name[] = {
+	[PROF_TABLE] = "table",
+	[PROF_LAP] = "lap",
+	[PROF_MOTION] = "motion",
+	[PROF_TRACE] = "trace",
+};
+
+#define PROF_INPUTS (IS_ENABLED(OTD_PROF_TRACE) ? PROF_TRACE + 1 : PROF_TRACE)
+
+static const char *const prof_model_name[] = {
+	[OTD_MODEL_0] = "0",
+	[OTD_MODEL_1] = "1",
+	[OTD_MODEL_2] = "2",
+};
+
+static const char *const prof_meta_name[] = {
+	[OTD_META_RESET] = "reset",
+	[OTD_META_DECREMENT] = "decrement",
+};
+
+/* Synthetic or recorded accelerometer input, one otd_input_t per call */
+struct prof_gen {
+	enum prof_input input;
+	uint32_t n;
+	uint32_t count;
+	uint32_t rng;
+};
+
+struct prof_result {
+	int status;
+	uint32_t init_cycles;
+	uint32_t runs;
+	uint64_t run_cycles;
+	uint32_t run_max;
+	/* calls that returned a classified window, and their cost */
+	uint32_t windows;
+	uint64_t window_call_cycles;
+	/* metaclassified output of every window */
+	uint32_t outputs[OTD_OTHER + 1];
+	size_t stack_used;
+};
+
+struct prof_job {
+	otd_state_t *state;
+	otd_model_t model;
+	otd_meta_t meta;
+	enum prof_input input;
+	/* run the harness without the library, for the stack baseline */
+	bool baseline;
+	struct prof_result res;
+};
+
+K_THREAD_STACK_DEFINE(prof_stack, CONFIG_OTD_PROF_STACK_SIZE);
+static struct k_thread prof_thread_data;
+
+/*
+ * Core clock cycles on RISC-V, which qemu counts as instructions when
+ * icount is on. Other targets fall back to the system timer.
+ */
+static inline uint32_t prof_cycles(void)
+{
+#ifdef CONFIG_RISCV
+	return csr_read(mcycle);
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+static float prof_noise(struct prof_gen *g, float amplitude)
+{
+	/* xorshift32 */
+	g->rng ^= g->rng << 13;
+	g->rng ^= g->rng >> 17;
+	g->rng ^= g->rng << 5;
+
+	return amplitude * ((float)(g->rng & 0xffff) / 32768.0f - 1.0f);
+}
+
+static void prof_gen_init(struct prof_gen *g, enum prof_input input)
+{
+	g->input = input;
+	g->n = 0;
+	g->rng = 0x1234567;
+	g->count = PROF_SAMPLES;
+
+#ifdef OTD_PROF_TRACE
+	if (input == PROF_TRACE) {
+		g->count = sizeof(otd_trace) / 6;
+	}
+#endif
+}
+
+static bool prof_gen_next(struct prof_gen *g, otd_input_t *in)
+{
+	float t = (float)g->n / OTD_ODR_HZ;
+	float sway;
+
+	if (g->n == g->count) {
+		return false;
+	}
+
+	switch (g->input) {
+	case PROF_TABLE:
+		/* flat and still, sensor noise only */
+		in->acc[0] = prof_noise(g, 3.0f);
+		in->acc[1] = prof_noise(g, 3.0f);
+		in->acc[2] = 1000.0f + prof_noise(g, 3.0f);
+		break;
+	case PROF_LAP:
+		/* tilted by about 8 degrees, slow sway and small movements */
+		sway = 25.0f * sinf(PROF_2PI * 0.3f * t) + 10.0f * sinf(PROF_2PI * 1.7f * t);
+		in->acc[0] = 20.0f + prof_noise(g, 8.0f);
+		in->acc[1] = 140.0f + sway + prof_noise(g, 8.0f);
+		in->acc[2] = 990.0f - 0.14f * sway + prof_noise(g, 8.0f);
+		break;
+	case PROF_MOTION:
+		/* carried while walking at 2 steps per second */
+		in->acc[0] = 150.0f * sinf(PROF_2PI * t) + prof_noise(g, 40.0f);
+		in->acc[1] = 300.0f + 80.0f * sinf(PROF_2PI * 2.0f * t + 1.0f) +
+			     prof_noise(g, 40.0f);
+		in->acc[2] = 950.0f + 300.0f * sinf(PROF_2PI * 2.0f * t) + prof_noise(g, 40.0f);
+		break;
+	default:
+#ifdef OTD_PROF_TRACE
+		for (int i = 0; i < 3; i++) {
+			in->acc[i] = (int16_t)sys_get_le16(&otd_trace[g->n * 6 + i * 2]);
+		}
+#endif
+		break;
+	}
+
+	g->n++;
+
+	return true;
+}
+
+static void prof_thread(void *p1, void *p2, void *p3)
+{
+	struct prof_job *job = p1;
+	struct prof_result *res = &job->res;
+	otd_config_t config = otd_get_default_config();
+	otd_output_t out_raw, out_meta = OTD_UNKNOWN;
+	otd_input_t in = { 0 };
+	struct prof_gen gen;
+	uint32_t start, cycles;
+	uint8_t window;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	/* same hysteresis as the sensor application */
+	config.hyst_ontable_ths = 20.0f;
+	config.hyst_onlap_ths = 5.0f;
+	config.hyst_other_ths = 5.0f;
+
+	start = prof_cycles();
+	res->status = job->baseline ? OTD_INIT_SUCCESS
+				    : otd_init(job->state, &config, job->meta, job->model);
+	res->init_cycles = prof_cycles() - start;
+
+	if (res->status != OTD_INIT_SUCCESS) {
+		return;
+	}
+
+	prof_gen_init(&gen, job->input);
+
+	while (prof_gen_next(&gen, &in)) {
+		start = prof_cycles();
+		window = job->baseline ? 0 : otd_run(job->state, &out_raw, &out_meta, &in);
+		cycles = prof_cycles() - start;
+
+		res->runs++;
+		res->run_cycles += cycles;
+		res->run_max = MAX(res->run_max, cycles);
+
+		if (window) {
+			res->windows++;
+			res->window_call_cycles += cycles;
+			res->outputs[MIN((unsigned int)out_meta, OTD_OTHER)]++;
+		}
+	}
+}
+
+/* Run @p job on a freshly painted stack and measure its high-water mark */
+static void prof_exec(struct prof_job *job)
+{
+	size_t unused = 0;
+	k_tid_t tid;
+
+	memset(&job->res, 0, sizeof(job->res));
+
+	tid = k_thread_create(&prof_thread_data, prof_stack, K_THREAD_STACK_SIZEOF(prof_stack),
+			      prof_thread, job, NULL, NULL,
+			      k_thread_priority_get(k_current_get()), 0, K_NO_WAIT);
+	k_thread_join(tid, K_FOREVER);
+
+	if (k_thread_stack_space_get(tid, &unused) == 0) {
+		job->res.stack_used = tid->stack_info.size - unused;
+	}
+}
+
+/* Highest offset written in @p len bytes painted with @p pattern */
+static size_t prof_state_used(const uint8_t *state, size_t len, uint8_t pattern)
+{
+	size_t used = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		if (state[i] != pattern) {
+			used = i + 1;
+		}
+	}
+
+	return used;
+}
+
+static void prof_print(const struct prof_job *job, size_t stack_baseline)
+{
+	const struct prof_result *res = &job->res;
+
+	printk("otd prof: model %s %s %s: %u runs, %u windows, run %llu cycles mean %u max, "
+	       "%llu cycles/window, window call %llu cycles mean, init %u cycles, "
+	       "stack %zu B, out %u/%u/%u/%u\n",
+	       prof_model_name[job->model], prof_meta_name[job->meta],
+	       prof_input_name[job->input], res->runs, res->windows,
+	       res->run_cycles / MAX(res->runs, 1), res->run_max,
+	       res->run_cycles / MAX(res->windows, 1),
+	       res->window_call_cycles / MAX(res->windows, 1), res->init_cycles,
+	       res->stack_used - MIN(res->stack_used, stack_baseline),
+	       res->outputs[OTD_UNKNOWN], res->outputs[OTD_ON_TABLE], res->outputs[OTD_ON_LAP],
+	       res->outputs[OTD_OTHER]);
+}
+
+int main(void)
+{
+	otd_state_t *state = otd_get_instance(0);
+	otd_state_t *next = otd_get_instance(1);
+	struct prof_job job = { .state = state };
+	size_t region = CONFIG_OTD_PROF_STATE_REGION;
+	size_t stack_baseline;
+	uint8_t instances = 0;
+	char version[12];
+
+	if (state == NULL) {
+		printk("otd prof: no algorithm instance\n");
+		return 0;
+	}
+
+	while (instances < UINT8_MAX && otd_get_instance(instances) != NULL) {
+		instances++;
+	}
+
+	if (next != NULL && next > state) {
+		region = (uint8_t *)next - (uint8_t *)state;
+	}
+
+	otd_get_version(version, sizeof(version));
+	job.baseline = true;
+	prof_exec(&job);
+	stack_baseline = job.res.stack_used;
+	job.baseline = false;
+
+	printk("otd prof: library %s, %u instances, %zu B painted per instance, "
+	       "%u s of input at %u Hz, stack baseline %zu B, cycles from %s\n",
+	       version, instances, region, CONFIG_OTD_PROF_SECONDS, OTD_ODR_HZ,
+	       stack_baseline, IS_ENABLED(CONFIG_RISCV) ? "mcycle" : "k_cycle_get_32");
+
+	for (int model = OTD_MODEL_0; model <= OTD_MODEL_2; model++) {
+		for (int meta = OTD_META_RESET; meta <= OTD_META_DECREMENT; meta++) {
+			size_t state_used = 0;
+
+			job.model = model;
+			job.meta = meta;
+
+			for (int input = 0; input < PROF_INPUTS; input++) {
+				/* two patterns, so no written byte goes unnoticed */
+				uint8_t pattern = (input & 1) ? 0x55 : 0xaa;
+
+				memset(state, pattern, region);
+				job.input = input;
+				prof_exec(&job);
+
+				if (job.res.status != OTD_INIT_SUCCESS) {
+					printk("otd prof: model %s %s: init failed with error %d\n",
+					       prof_model_name[model], prof_meta_name[meta],
+					       job.res.status);
+					break;
+				}
+
+				state_used = MAX(state_used,
+						 prof_state_used((uint8_t *)state, region, pattern));
+				prof_print(&job, stack_baseline);
+			}
+
+			if (job.res.status == OTD_INIT_SUCCESS) {
+				printk("otd prof: model %s %s: hash 0x%08x, state %zu B\n",
+				       prof_model_name[model], prof_meta_name[meta],
+				       otd_get_model_hash(state), state_used);
+			}
+		}
+	}
+
+	printk("otd prof: done\n");
+
+	return 0;
+}